@@ -0,0 +1,73 @@
+#include <elqtpch.h>
+#include "atlas_gen.h"
+
+#include <tools/cell.h>
+#include <tools/atlas.h>
+
+namespace el
+{
+	void createCellsFromRects(asset<Atlas> atlas, const vector<PixelRect>& rects, int width, int height) {
+		assert(atlas && atlas.has<AtlasMeta>());
+		auto& meta = atlas.get<AtlasMeta>();
+		meta.width = width;
+		meta.height = height;
+
+		for (sizet i = 0; i < rects.size(); i++) {
+			auto& rect = rects[i];
+			auto cell = gProject.make<SubAssetData>(meta.cellorder.size(), string(), atlas).add<CellMeta>();
+			atlas->addCell(cell, meta);
+
+			auto& cm = cell.get<CellMeta>();
+			cm = {
+				(sizet)rect.l, (sizet)rect.t,
+				(sizet)rect.width(), (sizet)rect.height(),
+				(sizet)cm.oX, (sizet)cm.oY
+			};
+			asset<Cell>(cell)->mold(cm, width, height);
+		}
+	}
+
+	void sortCellOrderOnNewGen(AtlasMeta& meta, uint sortorder, uint target_margin) {
+		auto& order = meta.cellorder;
+
+		std::sort(order.begin(), order.end(), [&](asset<Cell> lhs, asset<Cell> rhs) ->bool {
+			bool ret = false;
+			float margin;
+
+			auto lverti = lhs->uvUp;
+			auto rverti = rhs->uvUp;
+			auto lhori = lhs->uvLeft;
+			auto rhori = rhs->uvLeft;
+
+			if (sortorder == 0) {
+				margin = abs(lverti - rverti) * meta.height;
+				ret = (margin < target_margin) ? (lhori < rhori) : (lverti < rverti);
+			} else {
+				//margin = abs(lhori - rhori) * meta.width;
+				//ret = (margin < target_margin) ? (lhori < rhori) : (lverti > rverti);
+			}
+			return ret;
+			});
+
+		for (sizet i = 0; i < order.size(); i++)
+			asset<SubAssetData>(order[i])->index = i;
+	}
+
+	void renameCellsOnNewGen(asset<Atlas> atlas, const string& stem) {
+		atlas->cells.clear();
+
+		auto& meta = atlas.get<AtlasMeta>();
+		meta.cellnames.clear();
+
+		auto& order = meta.cellorder;
+		for (sizet i = 0; i < order.size(); i++) {
+			auto rname = stem + "_" + std::to_string(i);
+
+			auto data = asset<SubAssetData>(order[i]);
+			data->name = rname;
+
+			atlas->cells.emplace(rname, data);
+			meta.cellnames.emplace(data, rname);
+		}
+	}
+}
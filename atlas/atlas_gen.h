@@ -0,0 +1,19 @@
+#pragma once
+#include "pixel_block.h"
+
+namespace el
+{
+	struct Atlas;
+	struct AtlasMeta;
+
+	// Shared by the Cells view and the headless batch generator, so both produce identical atlases.
+
+	// Appends one cell per rect to an empty atlas and sizes the atlas to the texture
+	void createCellsFromRects(asset<Atlas> atlas, const vector<PixelRect>& rects, int width, int height);
+
+	// Reading order for freshly generated cells: rows within margin pixels of each other are treated as one line
+	void sortCellOrderOnNewGen(AtlasMeta& meta, uint sortorder, uint margin);
+
+	// Names every cell <stem>_<index> following cellorder, rebuilding Atlas::cells and AtlasMeta::cellnames
+	void renameCellsOnNewGen(asset<Atlas> atlas, const string& stem);
+}
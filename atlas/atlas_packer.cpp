@@ -0,0 +1,255 @@
+#include <elqtpch.h>
+#include "atlas_packer.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace el
+{
+	namespace
+	{
+		enum class PackHeuristic
+		{
+			BestShortSideFit,
+			BestLongSideFit,
+			BestAreaFit,
+			BottomLeft
+		};
+
+		struct MaxRectsBin
+		{
+			int width, height;
+			vector<PixelRect> freeRects, usedRects;
+
+			MaxRectsBin(int w, int h) : width(w), height(h) {
+				freeRects.emplace_back(0, 0, w, h);
+			}
+
+			bool insert(int w, int h, PackHeuristic heuristic, PixelRect& placed) {
+				auto intmax = std::numeric_limits<int>::max();
+				int bestScore1 = intmax, bestScore2 = intmax;
+				bool found = false;
+
+				for (auto& free : freeRects) {
+					if (free.width() < w || free.height() < h)
+						continue;
+
+					int leftoverW = free.width() - w;
+					int leftoverH = free.height() - h;
+					int score1 = 0, score2 = 0;
+					switch (heuristic) {
+						case PackHeuristic::BestShortSideFit:
+							score1 = min(leftoverW, leftoverH);
+							score2 = max(leftoverW, leftoverH);
+							break;
+						case PackHeuristic::BestLongSideFit:
+							score1 = max(leftoverW, leftoverH);
+							score2 = min(leftoverW, leftoverH);
+							break;
+						case PackHeuristic::BestAreaFit:
+							score1 = free.width() * free.height() - w * h;
+							score2 = min(leftoverW, leftoverH);
+							break;
+						case PackHeuristic::BottomLeft:
+							score1 = free.t + h;
+							score2 = free.l;
+							break;
+					}
+
+					if (score1 < bestScore1 || (score1 == bestScore1 && score2 < bestScore2)) {
+						bestScore1 = score1;
+						bestScore2 = score2;
+						placed = PixelRect(free.l, free.t, free.l + w, free.t + h);
+						found = true;
+					}
+				}
+
+				if (found)
+					place(placed);
+				return found;
+			}
+
+			void place(const PixelRect& node) {
+				for (sizet i = 0; i < freeRects.size();) {
+					if (split(freeRects[i], node)) {
+						freeRects[i] = freeRects.back();
+						freeRects.pop_back();
+					} else i++;
+				}
+				prune();
+				usedRects.push_back(node);
+			}
+
+			bool split(PixelRect free, const PixelRect& used) {
+				if (used.l >= free.r || used.r <= free.l || used.t >= free.b || used.b <= free.t)
+					return false;
+
+				if (used.l > free.l)
+					freeRects.emplace_back(free.l, free.t, used.l, free.b);
+				if (used.r < free.r)
+					freeRects.emplace_back(used.r, free.t, free.r, free.b);
+				if (used.t > free.t)
+					freeRects.emplace_back(free.l, free.t, free.r, used.t);
+				if (used.b < free.b)
+					freeRects.emplace_back(free.l, used.b, free.r, free.b);
+				return true;
+			}
+
+			static bool contains(const PixelRect& outer, const PixelRect& inner) {
+				return outer.l <= inner.l && outer.t <= inner.t && outer.r >= inner.r && outer.b >= inner.b;
+			}
+
+			void prune() {
+				for (sizet i = 0; i < freeRects.size(); i++) {
+					for (sizet j = i + 1; j < freeRects.size();) {
+						if (contains(freeRects[j], freeRects[i])) {
+							freeRects[i] = freeRects.back();
+							freeRects.pop_back();
+							i--;
+							break;
+						}
+						if (contains(freeRects[i], freeRects[j])) {
+							freeRects[j] = freeRects.back();
+							freeRects.pop_back();
+						} else j++;
+					}
+				}
+			}
+		};
+
+		struct PackCandidate
+		{
+			int width, height;
+			PackHeuristic heuristic;
+		};
+
+		bool packInto(const vector<PixelRect>& rects, const vector<sizet>& order, const PackCandidate& candidate, int spacing, vector<PixelRect>& out) {
+			// Spacing is added to every rect and to the bin once, so cells never touch but may meet the texture edge
+			MaxRectsBin bin(candidate.width + spacing, candidate.height + spacing);
+			out.assign(rects.size(), PixelRect());
+			for (auto i : order) {
+				PixelRect placed;
+				if (!bin.insert(rects[i].width() + spacing, rects[i].height() + spacing, candidate.heuristic, placed))
+					return false;
+				placed.r -= spacing;
+				placed.b -= spacing;
+				out[i] = placed;
+			}
+			return true;
+		}
+	}
+
+	AtlasPackResult packRects(const vector<PixelRect>& rects, const AtlasPackOptions& options) {
+		AtlasPackResult result;
+
+		sizet area = 0;
+		int widest = 1, tallest = 1;
+		for (auto& rect : rects) {
+			area += (sizet)(rect.width() + options.spacing) * (rect.height() + options.spacing);
+			widest = max(widest, rect.width());
+			tallest = max(tallest, rect.height());
+		}
+
+		// Tallest and widest first packs noticeably tighter than input order
+		vector<sizet> order(rects.size());
+		for (sizet i = 0; i < order.size(); i++)
+			order[i] = i;
+		std::sort(order.begin(), order.end(), [&](sizet lhs, sizet rhs) {
+			auto lmax = max(rects[lhs].width(), rects[lhs].height());
+			auto rmax = max(rects[rhs].width(), rects[rhs].height());
+			if (lmax != rmax)
+				return lmax > rmax;
+			return rects[lhs].width() * rects[lhs].height() > rects[rhs].width() * rects[rhs].height();
+		});
+
+		vector<PackCandidate> candidates;
+		PackHeuristic heuristics[] = {
+			PackHeuristic::BestShortSideFit, PackHeuristic::BestLongSideFit,
+			PackHeuristic::BestAreaFit, PackHeuristic::BottomLeft
+		};
+
+		if (options.width > 0 && options.height > 0) {
+			for (auto heuristic : heuristics)
+				candidates.push_back({ options.width, options.height, heuristic });
+		} else {
+			for (int w = 16; w <= options.maxSize; w *= 2) {
+				for (int h = max(16, w / 2); h <= min(options.maxSize, w * 2); h *= 2) {
+					if ((sizet)w * h >= area && w >= widest && h >= tallest)
+						candidates.push_back({ w, h, PackHeuristic::BestShortSideFit });
+				}
+			}
+			std::sort(candidates.begin(), candidates.end(), [](const PackCandidate& lhs, const PackCandidate& rhs) {
+				auto la = (sizet)lhs.width * lhs.height;
+				auto ra = (sizet)rhs.width * rhs.height;
+				if (la != ra)
+					return la < ra;
+				return abs(lhs.width - lhs.height) < abs(rhs.width - rhs.height);
+			});
+		}
+
+		// Sizes are tried smallest first, a few at a time in parallel, so a hard fit keeps growing up to the largest
+		// size without packing every candidate up front
+		static const sizet cWave = 6;
+		for (sizet first = 0; first < candidates.size(); first += cWave) {
+			auto count = min(cWave, candidates.size() - first);
+			vector<vector<PixelRect>> placements(count);
+			vector<char> fits(count, 0);
+			parallelFor(count, [&](sizet i) {
+				fits[i] = packInto(rects, order, candidates[first + i], options.spacing, placements[i]);
+			}, options.threads);
+
+			for (sizet i = 0; i < count; i++) {
+				if (fits[i]) {
+					result.success = true;
+					result.width = candidates[first + i].width;
+					result.height = candidates[first + i].height;
+					result.rects = std::move(placements[i]);
+					return result;
+				}
+			}
+		}
+		return result;
+	}
+
+	AtlasPackResult packPaddedRects(const vector<PixelRect>& rects, int padding, const AtlasPackOptions& options) {
+		vector<PixelRect> inflated;
+		inflated.reserve(rects.size());
+		for (auto& rect : rects)
+			inflated.emplace_back(0, 0, rect.width() + padding * 2, rect.height() + padding * 2);
+
+		auto padded = options;
+		padded.spacing = 0;
+		auto result = packRects(inflated, padded);
+		for (auto& rect : result.rects)
+			rect = PixelRect(rect.l + padding, rect.t + padding, rect.r - padding, rect.b - padding);
+		return result;
+	}
+
+	void blitRects(const PixelBlock& src, const vector<PixelRect>& from, const vector<PixelRect>& to, PixelBlock& dst, uint threads) {
+		assert(from.size() == to.size());
+		parallelFor(from.size(), [&](sizet i) {
+			auto& s = from[i];
+			auto& d = to[i];
+			auto w = min(s.width(), d.width());
+			auto h = min(s.height(), d.height());
+			for (int y = 0; y < h; y++) {
+				memcpy(
+					&dst.rgba[((sizet)(d.t + y) * dst.width + d.l) * 4],
+					&src.rgba[((sizet)(s.t + y) * src.width + s.l) * 4],
+					(sizet)w * 4
+				);
+			}
+		}, threads);
+	}
+
+	float rectOccupancy(const vector<PixelRect>& rects, int width, int height) {
+		if (width <= 0 || height <= 0)
+			return 0.0f;
+
+		double area = 0;
+		for (auto& rect : rects)
+			area += (double)rect.width() * rect.height();
+		return (float)(area / ((double)width * height));
+	}
+}
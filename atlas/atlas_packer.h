@@ -0,0 +1,40 @@
+#pragma once
+#include "pixel_block.h"
+
+namespace el
+{
+	struct AtlasPackOptions
+	{
+		// 0 picks the smallest power of two square or 2:1 texture that fits, no side larger than maxSize
+		int width, height, maxSize;
+		// Empty pixels kept between neighbouring cells
+		int spacing;
+		uint threads;
+
+		AtlasPackOptions() : width(0), height(0), maxSize(16384), spacing(1), threads(0) {}
+	};
+
+	struct AtlasPackResult
+	{
+		bool success;
+		int width, height;
+		// Same order as the rects that were packed
+		vector<PixelRect> rects;
+
+		AtlasPackResult() : success(false), width(0), height(0) {}
+	};
+
+	// MaxRects packer, only the sizes of the given rects are used.
+	// Candidate texture sizes (or heuristics, for a fixed size) are tried in parallel and the tightest fit wins.
+	AtlasPackResult packRects(const vector<PixelRect>& rects, const AtlasPackOptions& options);
+
+	// Packs rects with room for padding pixels around each one, options.spacing is ignored.
+	// Returned rects are the interiors, already offset by the padding
+	AtlasPackResult packPaddedRects(const vector<PixelRect>& rects, int padding, const AtlasPackOptions& options);
+
+	// Copies every from[i] block of src into to[i] of dst, cells in parallel. dst must already be sized
+	void blitRects(const PixelBlock& src, const vector<PixelRect>& from, const vector<PixelRect>& to, PixelBlock& dst, uint threads = 0);
+
+	// Fraction of a width x height texture covered by rects, assuming they don't overlap
+	float rectOccupancy(const vector<PixelRect>& rects, int width, int height);
+}
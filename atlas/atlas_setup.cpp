@@ -7,25 +7,38 @@
 #include <atlas/pivot_widget.h>
 #include <atlas/clips_widget.h>
 #include <apparatus/asset_loader.h>
+#include "../elqt/widget/memory_panel.h"
 
 namespace el
 {
-	AtlasSetup::AtlasSetup(QWidget* parent) : QMainWindow(parent) {
+	AtlasSetup::AtlasSetup(QWidget* parent) : QMainWindow(parent),
+		mPivotToolbar1(0), mPivotToolbar2(0), mPivotView(0), mClipsToolbar(0), mClipsWidget(0), mClipsTimer(0), mModeIdleMs(5 * 60 * 1000), mMemoryPanel(0)
+	{
 		cout << "Setting up Atlas Editor..." << endl;
 		ui.setupUi(this);
 		setupActions();
 		setupLayout();
 		setupList();
 		setupCellMode();
-		setupPivotMode();
-		setupClipMode();
 		setupInitView();
+		setupMemoryUsage();
+
+		mPivotIdleTimer = new QTimer(this);
+		mPivotIdleTimer->setSingleShot(true);
+		connect(mPivotIdleTimer, &QTimer::timeout, this, &AtlasSetup::releasePivotMode);
+		mClipsIdleTimer = new QTimer(this);
+		mClipsIdleTimer->setSingleShot(true);
+		connect(mClipsIdleTimer, &QTimer::timeout, this, &AtlasSetup::releaseClipMode);
 
 		QTimer* timer = new QTimer(this);
 		connect(timer, &QTimer::timeout, this, &AtlasSetup::loop);
 		timer->start(1000.0f / 60.0f);
 	}
 
+	AtlasSetup::~AtlasSetup() {
+		gEditorMemory.removeReporter(this);
+	}
+
 	void AtlasSetup::setupActions() {
 		mViewActions = new QActionGroup(this);
 		mViewActions->addAction(ui.actionCellsView);
@@ -44,11 +57,16 @@ namespace el
 					mPivotToolbar1->hide();
 					mPivotToolbar2->hide();
 					mPivotView->hideEditor();
+					if (mModeIdleMs > 0)
+						mPivotIdleTimer->start(mModeIdleMs);
 					gMouse.reset();
 					break;
 				case AtlasViewMode::Clips:
 					mClipsToolbar->hide();
 					mClipsWidget->hideEditor();
+					mClipsTimer->stop();
+					if (mModeIdleMs > 0)
+						mClipsIdleTimer->start(mModeIdleMs);
 					gMouse.reset();
 					break;
 			}
@@ -59,17 +77,81 @@ namespace el
 				mCellsWidget->showEditor();
 			} else if (action == ui.actionPivotView) {
 				mViewMode = AtlasViewMode::Pivot;
+				mPivotIdleTimer->stop();
+				pivotView()->showEditor();
 				mPivotToolbar1->show();
 				mPivotToolbar2->show();
-				mPivotView->showEditor();
 			} else if (action == ui.actionClipsView) {
 				mViewMode = AtlasViewMode::Clips;
+				mClipsIdleTimer->stop();
+				clipsWidget()->showEditor();
 				mClipsToolbar->show();
-				mClipsWidget->showEditor();
+				startClipsTimer();
 			}
 			});
 
 		mViewActions->setEnabled(true);
+
+		ui.menuView->addSeparator();
+		auto profiler = ui.menuView->addAction("Frame Profiler");
+		profiler->setShortcut(QKeySequence(Qt::Key_F3));
+		profiler->setCheckable(true);
+		connect(profiler, &QAction::toggled, [](bool checked) { QElangView::setProfiling(checked); });
+
+		auto record = ui.menuView->addAction("Record Trace");
+		record->setCheckable(true);
+		record->setChecked(Trace::enabled());
+		connect(record, &QAction::toggled, [](bool checked) { Trace::enable(checked); });
+		connect(ui.menuView->addAction("Save Trace..."), &QAction::triggered, [&]() {
+			fio::path path = QFileDialog::getSaveFileName(this, "Save Trace", gAtlasUtil.lastSearchHistory.generic_string().c_str(), "Chrome Trace (*.json)").toStdString();
+			if (!path.empty() && !Trace::dump(path))
+				QMessageBox::warning(this, "Save Trace", "Failed to write the trace file.");
+		});
+	}
+
+	void AtlasSetup::setupMemoryUsage() {
+		gEditorMemory.addReporter(this, [](vector<MemoryUsage>& rows) {
+			auto texture = [&](const string& name, asset<Material> material) {
+				if (material && material->hasTexture()) {
+					auto tex = material->textures[0];
+					if (auto bytes = QElangMemoryUsage::textureBytes(tex)) {
+						auto file = tex.get<AssetData>().filePath.filename().generic_u8string();
+						rows.push_back({ "Textures", name + (file.empty() ? "" : " " + file) + " (" + std::to_string(tex->width())
+							+ "x" + std::to_string(tex->height()) + ")", 0, bytes, false });
+					}
+				}
+			};
+			texture("Sheet", gAtlasUtil.currentMaterial);
+			texture("Ghost", gAtlasUtil.ghostMaterial);
+			texture("Thumbnail page", gAtlasUtil.thumbnailMaterial);
+
+			gEditorGL.reportMemory(rows);
+
+			// Palettes, the cells view and ghost pickers all hold CellHolders, one per cell of their atlas
+			auto holders = gProject.view<CellHolder>().size();
+			if (holders > 0)
+				rows.push_back({ "Cells", "Cell holders (" + std::to_string(holders) + ")", holders * sizeof(CellHolder), 0, false });
+
+			auto listBytes = [](QListWidget* list, sizet itemSize) {
+				sizet bytes = 0;
+				for (int i = 0; i < list->count(); i++)
+					bytes += itemSize + list->item(i)->text().size() * sizeof(QChar);
+				return bytes;
+			};
+			if (gAtlasUtil.cellList && gAtlasUtil.cellList->count() > 0) {
+				rows.push_back({ "Cells", "Cell list items (" + std::to_string(gAtlasUtil.cellList->count()) + ")",
+					listBytes(gAtlasUtil.cellList, sizeof(CellItem)), 0, true });
+			}
+			if (gAtlasUtil.clipList && gAtlasUtil.clipList->count() > 0) {
+				rows.push_back({ "Clips", "Clip list items (" + std::to_string(gAtlasUtil.clipList->count()) + ")",
+					listBytes(gAtlasUtil.clipList, sizeof(ClipItem)), 0, true });
+			}
+		});
+
+		mMemoryPanel = new QElangMemoryPanel(this);
+		addDockWidget(Qt::RightDockWidgetArea, mMemoryPanel);
+		mMemoryPanel->hide();
+		ui.menuView->addAction(mMemoryPanel->toggleViewAction());
 	}
 
 	void AtlasSetup::loop() {
@@ -119,11 +201,46 @@ namespace el
 		mCellsWidget->showEditor();
 
 		gAtlasUtil.clipList->hide();
-		mPivotView->hide();
-		mPivotToolbar1->hide();
-		mPivotToolbar2->hide();
-		mClipsWidget->hide();
-		mClipsToolbar->hide();
+	}
+
+	void AtlasSetup::setModeIdleRelease(int seconds) {
+		mModeIdleMs = max(seconds, 0) * 1000;
+		if (mModeIdleMs == 0) {
+			mPivotIdleTimer->stop();
+			mClipsIdleTimer->stop();
+		}
+	}
+
+	PivotView* AtlasSetup::pivotView() {
+		if (!mPivotToolbar1)
+			setupPivotMode();
+		if (!mPivotView)
+			createPivotView();
+		return mPivotView;
+	}
+
+	ClipsWidget* AtlasSetup::clipsWidget() {
+		if (!mClipsToolbar)
+			setupClipMode();
+		if (!mClipsWidget)
+			createClipsWidget();
+		return mClipsWidget;
+	}
+
+	void AtlasSetup::releasePivotMode() {
+		if (mPivotView && mViewMode != AtlasViewMode::Pivot) {
+			cout << "Releasing idle Pivot mode" << endl;
+			mPivotView->deleteLater();
+			mPivotView = 0;
+		}
+	}
+
+	void AtlasSetup::releaseClipMode() {
+		if (mClipsWidget && mViewMode != AtlasViewMode::Clips) {
+			cout << "Releasing idle Clips mode" << endl;
+			mClipsWidget->deleteLater();
+			mClipsWidget = 0;
+		}
 	}
 
 	void AtlasSetup::setupCellMode() {
@@ -136,6 +253,9 @@ namespace el
 		auto combine = mCellToolbar->addAction("Combine Cells", [&]() { mCellsWidget->combineCells(); });
 		combine->setShortcut(QKeySequence(Qt::Key_C));
 
+		auto trim = mCellToolbar->addAction("Trim Cells", [&]() { mCellsWidget->trimCells(); });
+		trim->setShortcut(QKeySequence(Qt::Key_T));
+
 		auto remove = mCellToolbar->addAction("Remove Cells", [&]() { mCellsWidget->deleteSelected(); });
 		remove->setShortcut(QKeySequence(Qt::Key_Delete));
 		mCellToolbar->addSeparator();
@@ -186,13 +306,16 @@ namespace el
 		captureGhost->setShortcut(QKeySequence(Qt::Key_C));
 		auto paletteGhost = mPivotToolbar2->addAction("Palette Ghost", [&]() { mPivotView->ghostPalette(); });
 		paletteGhost->setShortcut(QKeySequence(Qt::Key_Space));
+		auto alignGhost = mPivotToolbar2->addAction("Align To Ghost", [&]() { mPivotView->autoAlignToGhost(); });
+		alignGhost->setShortcut(QKeySequence(Qt::Key_X));
+		mPivotToolbar2->addAction("Align Clip", [&]() { mPivotView->autoAlignClip(); });
 
 		mPivotToolbar2->addSeparator();
 
 		auto backGhost = mPivotToolbar2->addAction("Back Ghost");
 		backGhost->setShortcut(QKeySequence(Qt::Key_B));
 		backGhost->setCheckable(true);
-		auto frontGhost = mPivotToolbar2->addAction("Front Ghost");
+		auto frontGhost = mFrontGhostAction = mPivotToolbar2->addAction("Front Ghost");
 		frontGhost->setShortcut(QKeySequence(Qt::Key_F));
 		frontGhost->setCheckable(true);
 
@@ -211,22 +334,46 @@ namespace el
 
 		mPivotToolbar2->addSeparator();
 
-		mPivotView = new PivotView(this);
-		mPivotView->setMinimumWidth(750);
-		mPivotView->sig_Modified.connect([&]() { setModified(); });
-		mViewLayout->addWidget(mPivotView);
+		QLabel* onionLabel = new QLabel("  Onion  ", mPivotToolbar2);
+		QSpinBox* onionBox = mOnionBox = new QSpinBox(mPivotToolbar2);
+		onionBox->setRange(0, 8);
+		mPivotToolbar2->addWidget(onionLabel);
+		mPivotToolbar2->addWidget(onionBox);
+		connect(onionBox, &QSpinBox::valueChanged, [&](int value) { mPivotView->setOnionDepth(value); });
+		auto onionClip = mOnionClipAction = mPivotToolbar2->addAction("Onion From Clip");
+		onionClip->setCheckable(true);
+		connect(onionClip, &QAction::toggled, [&](bool checked) { mPivotView->setOnionFromClip(checked); });
+
+		mPivotToolbar2->addSeparator();
 
 		addToolBarBreak();
 		addToolBar(Qt::ToolBarArea::TopToolBarArea, mPivotToolbar1);
 		addToolBarBreak();
 		addToolBar(Qt::ToolBarArea::TopToolBarArea, mPivotToolbar2);
+		mPivotToolbar1->hide();
+		mPivotToolbar2->hide();
+	}
+
+	void AtlasSetup::createPivotView() {
+		EL_TRACE_SCOPE("createPivotView");
+		mPivotView = new PivotView(this);
+		mPivotView->setMinimumWidth(750);
+		mPivotView->sig_Modified.connect([&]() { setModified(); });
+		mViewLayout->addWidget(mPivotView);
+		mPivotView->hide();
+
+		// A rebuilt view picks up the settings the toolbars were left at
+		mPivotView->setOnionDepth(mOnionBox->value());
+		mPivotView->setOnionFromClip(mOnionClipAction->isChecked());
+		mPivotView->setGhostPosition(mFrontGhostAction->isChecked());
 	}
 
 
 	void AtlasSetup::setupClipMode() {
 		mClipsToolbar = new QToolBar(this);
 		QLabel* label = new QLabel("  FPS  ", mClipsToolbar);
-		QSpinBox* box = new QSpinBox(mClipsToolbar);
+		QSpinBox* box = mFpsBox = new QSpinBox(mClipsToolbar);
+		box->setMinimum(1);
 		box->setMaximum(999);
 
 		mClipsToolbar->addAction("Create Clip", [&]() { mClipsWidget->createClip(); });
@@ -238,28 +385,50 @@ namespace el
 
 		auto recenterCam = mClipsToolbar->addAction("Recenter Camera", [&]() { mClipsWidget->recenterCamera(); });
 		recenterCam->setShortcut(QKeySequence(Qt::Key_G));
+		auto gridPreview = mGridAction = mClipsToolbar->addAction("Grid Preview");
+		gridPreview->setCheckable(true);
+		connect(gridPreview, &QAction::toggled, [&](bool checked) { mClipsWidget->setGridPreview(checked); });
 		mClipsToolbar->addSeparator();
 
 		mClipsToolbar->addWidget(label);
 		mClipsToolbar->addWidget(box);
+		auto timing = mTimingAction = mClipsToolbar->addAction("Timing Stats");
+		timing->setCheckable(true);
+		connect(timing, &QAction::toggled, [&](bool checked) { mClipsWidget->setTimingOverlay(checked); });
 		mClipsToolbar->addSeparator();
 
-		mClipsWidget = new ClipsWidget(this);
-		mClipsWidget->setMinimumWidth(750);
-		mClipsWidget->sig_Modified.connect([&]() { setModified(); });
-		mViewLayout->addWidget(mClipsWidget);
-
 		mClipsTimer = new QTimer(this);
-		connect(mClipsTimer, &QTimer::timeout, mClipsWidget, &ClipsWidget::animLoop);
-		mClipsTimer->start(1000.0f / 30.0f);
+		mClipsTimer->setTimerType(Qt::PreciseTimer);
 		box->setValue(30.0f);
 
 		connect(box, &QSpinBox::valueChanged, [&](int value) {
-			mClipsTimer->stop();
-			mClipsTimer->start(1000.0f / value);
+			mClipsWidget->setFrameRate(value);
+			startClipsTimer();
 		});
 
 		addToolBar(Qt::ToolBarArea::TopToolBarArea, mClipsToolbar);
+		mClipsToolbar->hide();
+	}
+
+	void AtlasSetup::createClipsWidget() {
+		EL_TRACE_SCOPE("createClipsWidget");
+		mClipsWidget = new ClipsWidget(this);
+		mClipsWidget->setMinimumWidth(750);
+		mClipsWidget->sig_Modified.connect([&]() { setModified(); });
+		mViewLayout->addWidget(mClipsWidget);
+		mClipsWidget->hide();
+
+		mClipsWidget->setFrameRate(mFpsBox->value());
+		mClipsWidget->setGridPreview(mGridAction->isChecked());
+		mClipsWidget->setTimingOverlay(mTimingAction->isChecked());
+		connect(mClipsTimer, &QTimer::timeout, mClipsWidget, &ClipsWidget::animLoop);
+	}
+
+	void AtlasSetup::startClipsTimer() {
+		// The timer only polls, at twice the frame rate; ClipsWidget measures real time to decide when a frame is due.
+		// It only runs while Clips mode is shown
+		if (mViewMode == AtlasViewMode::Clips)
+			mClipsTimer->start(max(1, (int)(500.0f / mFpsBox->value())));
 	}
 
 	void AtlasSetup::updateEditorTitle(asset<Atlas> atlas) {
@@ -7,12 +7,18 @@ namespace el
 	class CellsWidget;
 	class PivotView;
 	class ClipsWidget;
+	class QElangMemoryPanel;
 	class AtlasSetup : public QMainWindow
 	{
 		Q_OBJECT
 
 	public:
 		AtlasSetup(QWidget* parent = nullptr);
+		~AtlasSetup();
+
+		// Pivot and Clips modes are built the first time they are shown. A mode left hidden this long is torn down
+		// and rebuilt on its next use, 0 keeps it for the whole session
+		void setModeIdleRelease(int seconds);
 
 	protected:
 		AtlasViewMode mViewMode;
@@ -25,10 +31,23 @@ namespace el
 
 		QToolBar* mPivotToolbar1, * mPivotToolbar2;
 		PivotView* mPivotView;
+		QSpinBox* mOnionBox;
+		QAction* mOnionClipAction, * mFrontGhostAction;
 
 		QToolBar* mClipsToolbar;
 		ClipsWidget* mClipsWidget;
 		QTimer* mClipsTimer;
+		QSpinBox* mFpsBox;
+		QAction* mGridAction, * mTimingAction;
+
+		QTimer* mPivotIdleTimer, * mClipsIdleTimer;
+		int mModeIdleMs;
+
+		QElangMemoryPanel* mMemoryPanel;
+
+		// Both build their mode on first call
+		PivotView* pivotView();
+		ClipsWidget* clipsWidget();
 
 		Ui::AtlasEditorUI ui;
 		void updateEditorTitle(asset<Atlas>);
@@ -43,5 +62,11 @@ namespace el
 		void setupCellMode();
 		void setupPivotMode();
 		void setupClipMode();
+		void setupMemoryUsage();
+		void createPivotView();
+		void createClipsWidget();
+		void releasePivotMode();
+		void releaseClipMode();
+		void startClipsTimer();
 	};
 };
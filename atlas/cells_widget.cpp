@@ -10,6 +10,12 @@
 #include <common/algorithm.h>
 #include <apparatus/ui.h>
 #include "../elqt/color_code.h"
+#include "../elqt/widget/cell_holders.h"
+#include "atlas_gen.h"
+#include "pixel_ops.h"
+#include "parallel.h"
+#include <tools/clip.h>
+#include <unordered_map>
 
 namespace el
 {
@@ -24,9 +30,12 @@ namespace el
 			if (mAtlas && mAtlas.has<AssetLoaded>()) {
 				color8 c = selectColoring();
 				auto& cells = mAtlas.get<AtlasMeta>().cellorder;
+				auto view = viewBox();
 				for (asset<AtlasSelectedCell> selected : cells) {
 					if (selected) {
 						auto& holder = selected.get<CellHolder>();
+						if (!holder.rect.intersects(view))
+							continue;
 						c.a = 255;
 						mHighlighter->line.batchAABB(holder.rect, c, 0.0f);
 						c.a = gEditorColor.cellFillAlpha;
@@ -88,6 +97,7 @@ namespace el
 
 	void CellsWidget::autoNewGenAtlas(asset<Atlas> atlas, uint sortorder, uint target_margin) {
 		if (mMaterial && mMaterial->hasTexture() && atlas && atlas.has<AtlasMeta>() && atlas.has<AssetData>()) {
+			EL_TRACE_SCOPE("autoNewGenAtlas");
 			mMaterial->textures[0]->autoGenerateAtlas(atlas, mAlphaCut);
 			mAtlas = atlas;
 			sortAtlasOnNewGen(sortorder, target_margin);
@@ -97,58 +107,366 @@ namespace el
 	}
 
 	void CellsWidget::renameAll() {
-		auto& cells = *gAtlasUtil.cellList;
-		mAtlas->cells.clear();
+		renameCellsOnNewGen(mAtlas, mAtlas.get<AssetData>().filePath.stem().generic_u8string());
+
+		for (asset<SubAssetData> data : mAtlas.get<AtlasMeta>().cellorder) {
+			auto& item = data.get<CellItem*>();
+			item->setText(QString::fromUtf8(data->name));
+		}
+	}
+
+	void CellsWidget::sortAtlasOnNewGen(uint sortorder, uint target_margin) {
+		assert(mAtlas);
+		assert(mAtlas.has<AtlasMeta>());
+		sortCellOrderOnNewGen(mAtlas.get<AtlasMeta>(), sortorder, target_margin);
+	}
+
+	bool CellsWidget::readTexturePixels(PixelBlock& pixels) {
+		if (mMaterial && mMaterial->hasTexture()) {
+			EL_TRACE_SCOPE("readTexturePixels");
+			ui.view->makeCurrent();
+			return pixels.loadFromTexture(mMaterial->textures[0]);
+		} return false;
+	}
+
+	vector<PixelRect> CellsWidget::cellPixelRects(const PixelBlock& pixels) {
+		auto bounds = pixels.bounds();
+		vector<PixelRect> rects;
+		if (mAtlas) {
+			auto& order = mAtlas.get<AtlasMeta>().cellorder;
+			rects.reserve(order.size());
+			for (asset<CellHolder> holder : order)
+				rects.push_back(PixelRect::fromBox(holder->rect).clipped(bounds));
+		} return rects;
+	}
+
+	vector<asset<CellHolder>> CellsWidget::selectedOrAllHolders() {
+		vector<asset<CellHolder>> holders;
+		for (asset<CellHolder> holder : gProject.view<AtlasSelectedCell>())
+			holders.push_back(holder);
+		if (holders.empty() && mAtlas) {
+			for (asset<CellHolder> holder : mAtlas.get<AtlasMeta>().cellorder)
+				holders.push_back(holder);
+		} return holders;
+	}
+
+	sizet CellsWidget::dedupeCells() {
+		if (!mAtlas || !mAtlas.has<AssetLoaded>())
+			return 0;
+
+		PixelBlock pixels;
+		if (!readTexturePixels(pixels))
+			return 0;
 
 		auto& meta = mAtlas.get<AtlasMeta>();
-		meta.cellnames.clear();
+		auto order = meta.cellorder;
+		auto rects = cellPixelRects(pixels);
+
+		vector<uint64_t> hashes(order.size());
+		parallelFor(order.size(), [&](sizet i) { hashes[i] = hashPixels(pixels, rects[i]); });
+
+		// Cells only merge when the frames would play identically, so the pivot and hitbox have to match too
+		auto sameFrame = [&](sizet i, sizet j) {
+			asset<CellHolder> a = order[i], b = order[j];
+			auto& am = a.get<CellMeta>();
+			auto& bm = b.get<CellMeta>();
+			auto& ah = a->hitbox;
+			auto& bh = b->hitbox;
+			return am.oX == bm.oX && am.oY == bm.oY && ah.l == bh.l && ah.b == bh.b && ah.r == bh.r && ah.t == bh.t;
+		};
+
+		// First cell in list order with the same pixels stays, hash collisions are ruled out byte for byte.
+		// Cells lying outside the texture have no pixels to compare and are left alone
+		std::unordered_map<uint64_t, vector<sizet>> buckets;
+		std::unordered_map<Entity, asset<Cell>> canonical;
+		for (sizet i = 0; i < order.size(); i++) {
+			if (rects[i].empty())
+				continue;
+
+			auto& bucket = buckets[hashes[i]];
+			bool duplicate = false;
+			for (auto j : bucket) {
+				if (sameFrame(i, j) && equalPixels(pixels, rects[i], rects[j])) {
+					canonical.emplace(order[i], order[j]);
+					duplicate = true;
+					break;
+				}
+			}
+			if (!duplicate)
+				bucket.push_back(i);
+		}
 
-		auto name = mAtlas.get<AssetData>().filePath.stem().generic_u8string();
+		if (canonical.empty())
+			return 0;
 
-		auto& order = meta.cellorder;
+		for (asset<Clip> clip : meta.cliporder) {
+			for (auto& frame : clip->cells) {
+				auto it = canonical.find(frame);
+				if (it != canonical.end())
+					frame = it->second;
+			}
+		}
 
-		for (auto i = 0; i < order.size(); i++) {
-			auto rname = name + "_" + std::to_string(i);
+		safeClearSelection();
+		mSuppressSelect = true;
+		for (auto& pair : canonical)
+			deleteCell(asset<CellHolder>(pair.first));
+		mSuppressSelect = false;
 
-			auto data = asset<SubAssetData>(meta.cellorder[i]);
-			data->name = rname;
+		reorderCellsAccordingToList();
+		rebatchAllCellHolders();
+		sig_Modified.invoke();
+		ui.view->update();
+		return canonical.size();
+	}
 
-			auto& item = data.get<CellItem*>();
-			item->setText(QString::fromUtf8(rname));
+	sizet CellsWidget::trimCells() {
+		if (!mAtlas || !mAtlas.has<AssetLoaded>())
+			return 0;
+
+		PixelBlock pixels;
+		if (!readTexturePixels(pixels))
+			return 0;
 
-			mAtlas->cells.emplace(rname, data);
-			meta.cellnames.emplace(data, name);
+		auto& meta = mAtlas.get<AtlasMeta>();
+		auto holders = selectedOrAllHolders();
+		auto bounds = pixels.bounds();
+		vector<PixelRect> rects(holders.size()), trimmed(holders.size());
+		for (sizet i = 0; i < holders.size(); i++)
+			rects[i] = PixelRect::fromBox(holders[i]->rect).clipped(bounds);
+		parallelFor(holders.size(), [&](sizet i) { trimmed[i] = opaqueBounds(pixels, rects[i], mAlphaCut); });
+
+		sizet count = 0;
+		for (sizet i = 0; i < holders.size(); i++) {
+			auto& before = rects[i];
+			auto& after = trimmed[i];
+			if (after.empty() || after == before)
+				continue;
+
+			// Pull the pivot along with the removed top-left margin so the sprite doesn't move on screen
+			auto holder = holders[i];
+			auto& cm = holder.get<CellMeta>();
+			cm.oX -= after.l - before.l;
+			cm.oY -= after.t - before.t;
+			holder->rect = after.toBox();
+			holder->moldCellFromRect(holder, (int)meta.width, (int)meta.height);
+			count++;
 		}
+
+		if (count > 0) {
+			rebatchAllCellHolders();
+			sig_Modified.invoke();
+			ui.view->update();
+		} return count;
 	}
 
-	void CellsWidget::sortAtlasOnNewGen(uint sortorder, uint target_margin) {
-		assert(mAtlas);
-		assert(mAtlas.has<AtlasMeta>());
+	sizet CellsWidget::autoPivots(PivotRule rule, uint alphaCut) {
+		if (!mAtlas || !mAtlas.has<AssetLoaded>())
+			return 0;
+
+		PixelBlock pixels;
+		if (!readTexturePixels(pixels))
+			return 0;
 
 		auto& meta = mAtlas.get<AtlasMeta>();
-		auto& order = meta.cellorder;
+		auto holders = selectedOrAllHolders();
+		auto bounds = pixels.bounds();
+		vector<PixelRect> rects(holders.size());
+		for (sizet i = 0; i < holders.size(); i++)
+			rects[i] = PixelRect::fromBox(holders[i]->rect).clipped(bounds);
+
+		// Pivot in pixels from the cell's top-left corner, which is exactly what oX/oY hold
+		vector<vec2> pivots(holders.size());
+		vector<char> found(holders.size(), 0);
+		parallelFor(holders.size(), [&](sizet i) {
+			auto opaque = opaqueBounds(pixels, rects[i], alphaCut);
+			if (opaque.empty())
+				return;
 
-		std::sort(order.begin(), order.end(), [&](asset<Cell> lhs, asset<Cell> rhs) ->bool {
-			bool ret = false;
-			float margin;
-
-			auto lverti = lhs->uvUp;
-			auto rverti = rhs->uvUp;
-			auto lhori = lhs->uvLeft;
-			auto rhori = rhs->uvLeft;
-
-			if (sortorder == 0) {
-				margin = abs(lverti - rverti) * meta.height;
-				ret = (margin < target_margin) ? (lhori < rhori) : (lverti < rverti);
-			} else {
-				//margin = abs(lhori - rhori) * meta.width;
-				//ret = (margin < target_margin) ? (lhori < rhori) : (lverti > rverti);
+			float x = 0.0f, y = 0.0f;
+			switch (rule) {
+				case PivotRule::BottomCenter:
+					x = (opaque.l + opaque.r) / 2.0f;
+					y = (float)opaque.b;
+					break;
+				case PivotRule::Center:
+					x = (opaque.l + opaque.r) / 2.0f;
+					y = (opaque.t + opaque.b) / 2.0f;
+					break;
+				case PivotRule::AlphaCentroid:
+					alphaCentroid(pixels, opaque, alphaCut, x, y);
+					break;
 			}
-			return ret;
-			});
+			pivots[i] = vec2(x - rects[i].l, y - rects[i].t);
+			found[i] = 1;
+		});
+
+		sizet count = 0;
+		for (sizet i = 0; i < holders.size(); i++) {
+			if (!found[i])
+				continue;
+
+			auto holder = holders[i];
+			auto& cm = holder.get<CellMeta>();
+			int oX = (int)round(pivots[i].x);
+			int oY = (int)round(pivots[i].y);
+			if (oX == cm.oX && oY == cm.oY)
+				continue;
+
+			// Hitboxes are relative to the pivot, move them with the art so they keep covering it
+			auto& hitbox = holder->hitbox;
+			if (hitbox.l != hitbox.r || hitbox.b != hitbox.t)
+				hitbox.move(vec2(-(oX - cm.oX), oY - cm.oY));
+			cm.oX = oX;
+			cm.oY = oY;
+			holder->moldCellFromRect(holder, (int)meta.width, (int)meta.height);
+			count++;
+		}
+
+		if (count > 0) {
+			rebatchAllCellHolders();
+			sig_Modified.invoke();
+			ui.view->update();
+		} return count;
+	}
+
+	sizet CellsWidget::autoHitboxes(uint alphaCut) {
+		if (!mAtlas || !mAtlas.has<AssetLoaded>())
+			return 0;
+
+		PixelBlock pixels;
+		if (!readTexturePixels(pixels))
+			return 0;
+
+		auto holders = selectedOrAllHolders();
+		auto bounds = pixels.bounds();
+		vector<PixelRect> rects(holders.size()), opaque(holders.size());
+		for (sizet i = 0; i < holders.size(); i++)
+			rects[i] = PixelRect::fromBox(holders[i]->rect).clipped(bounds);
+		parallelFor(holders.size(), [&](sizet i) { opaque[i] = opaqueBounds(pixels, rects[i], alphaCut); });
+
+		sizet count = 0;
+		for (sizet i = 0; i < holders.size(); i++) {
+			if (opaque[i].empty())
+				continue;
+
+			// The cell's top-left pixel is drawn at (-oX, oY) around the pivot
+			auto holder = holders[i];
+			auto& cm = holder.get<CellMeta>();
+			auto l = opaque[i].l - rects[i].l;
+			auto t = opaque[i].t - rects[i].t;
+			auto r = opaque[i].r - rects[i].l;
+			auto b = opaque[i].b - rects[i].t;
+			holder->hitbox = Box((float)(l - cm.oX), (float)(cm.oY - b), (float)(r - cm.oX), (float)(cm.oY - t));
+			count++;
+		}
+
+		if (count > 0) {
+			sig_Modified.invoke();
+			ui.view->update();
+		} return count;
+	}
 
-		for (sizet i = 0; i < order.size(); i++)
-			asset<SubAssetData>(order[i])->index = i;
+	bool CellsWidget::exportPadded(const fio::path& texturePath, int padding) {
+		if (!mAtlas || !mAtlas.has<AssetLoaded>())
+			return false;
+
+		PixelBlock pixels;
+		if (!readTexturePixels(pixels))
+			return false;
+
+		auto& meta = mAtlas.get<AtlasMeta>();
+		auto& order = meta.cellorder;
+		auto rects = cellPixelRects(pixels);
+		auto result = packPaddedRects(rects, padding, AtlasPackOptions());
+		if (!result.success)
+			return false;
+
+		PixelBlock padded;
+		padded.width = result.width;
+		padded.height = result.height;
+		padded.rgba.assign((sizet)result.width * result.height * 4, 0);
+		blitRects(pixels, rects, result.rects, padded);
+		parallelFor(result.rects.size(), [&](sizet i) { extrudeRect(padded, result.rects[i], padding); });
+
+		QImage image(padded.rgba.data(), padded.width, padded.height, padded.width * 4, QImage::Format_RGBA8888);
+		if (!image.save(QString::fromUtf8(texturePath.generic_u8string()), "PNG"))
+			return false;
+
+		// The exported atlas points its UVs at the interiors, then the working atlas is put back untouched
+		vector<Box> savedRects;
+		savedRects.reserve(order.size());
+		auto width = meta.width;
+		auto height = meta.height;
+		meta.width = result.width;
+		meta.height = result.height;
+		for (sizet i = 0; i < order.size(); i++) {
+			asset<CellHolder> holder = order[i];
+			savedRects.push_back(holder->rect);
+			holder->rect = result.rects[i].toBox();
+			holder->moldCellFromRect(holder, result.width, result.height);
+		}
+
+		auto atlasPath = texturePath;
+		atlasPath.replace_extension(".atls");
+		mAtlas->exportFile(atlasPath, meta);
+
+		meta.width = width;
+		meta.height = height;
+		for (sizet i = 0; i < order.size(); i++) {
+			asset<CellHolder> holder = order[i];
+			holder->rect = savedRects[i];
+			holder->moldCellFromRect(holder, (int)width, (int)height);
+		}
+		return true;
+	}
+
+	bool CellsWidget::repackCells(const AtlasPackOptions& options, PixelBlock& packed, AtlasPackResult& result, float& occupancyBefore, float& occupancyAfter) {
+		if (!mAtlas || !mAtlas.has<AssetLoaded>())
+			return false;
+
+		PixelBlock pixels;
+		if (!readTexturePixels(pixels))
+			return false;
+
+		auto& meta = mAtlas.get<AtlasMeta>();
+		auto& order = meta.cellorder;
+		if (order.empty())
+			return false;
+
+		auto rects = cellPixelRects(pixels);
+		result = packRects(rects, options);
+		if (!result.success)
+			return false;
+
+		packed.width = result.width;
+		packed.height = result.height;
+		packed.rgba.assign((sizet)result.width * result.height * 4, 0);
+		blitRects(pixels, rects, result.rects, packed, options.threads);
+
+		occupancyBefore = rectOccupancy(rects, pixels.width, pixels.height);
+		occupancyAfter = rectOccupancy(result.rects, result.width, result.height);
+		return true;
+	}
+
+	void CellsWidget::applyRepack(const AtlasPackResult& result) {
+		if (!mAtlas || !mAtlas.has<AssetLoaded>() || !result.success)
+			return;
+
+		auto& meta = mAtlas.get<AtlasMeta>();
+		auto& order = meta.cellorder;
+		if (order.size() != result.rects.size())
+			return;
+
+		// Only the sheet position changes; CellMeta pivots and hitboxes are relative to the cell and stay as they are
+		meta.width = result.width;
+		meta.height = result.height;
+		for (sizet i = 0; i < order.size(); i++) {
+			asset<CellHolder> holder = order[i];
+			holder->rect = result.rects[i].toBox();
+			holder->moldCellFromRect(holder, result.width, result.height);
+		}
+		sig_Modified.invoke();
 	}
 
 	void CellsWidget::reorderCellsAccordingToList() {
@@ -277,14 +595,10 @@ namespace el
 							gAtlasUtil.cellList->clearSelection();
 							mSelectRect.normalize();
 
-							gProject.clear<AtlasSelectedCell>();
-							auto& meta = mAtlas.get<AtlasMeta>();
-							for (asset<CellHolder> holder : meta.cellorder) {
-								if (holder->rect.intersects(mSelectRect)) {
-									gProject.get_or_emplace<AtlasSelectedCell>(holder);
-									assert(holder.has<CellItem*>());
-									holder.get<CellItem*>()->setSelected(true);
-								}
+							selectCellHolders<AtlasSelectedCell>(meta, mSelectRect);
+							for (asset<CellHolder> holder : selected) {
+								assert(holder.has<CellItem*>());
+								holder.get<CellItem*>()->setSelected(true);
 							}
 
 							if (selected.size() > 0) {
@@ -598,6 +912,7 @@ namespace el
 	}
 
 	void CellsWidget::recreateList() {
+		EL_TRACE_SCOPE("CellsWidget::recreateList");
 		auto& list = *gAtlasUtil.cellList;
 		for (auto i = 0; i < list.count(); i++) {
 			delete list.item(i);
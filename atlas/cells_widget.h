@@ -1,6 +1,7 @@
 #pragma once
 #include "../elqt/widget/palette.h"
 #include "util.h"
+#include "atlas_packer.h"
 
 namespace el
 {;
@@ -8,6 +9,13 @@ namespace el
 	{
 		Q_OBJECT
 	public:
+		enum class PivotRule
+		{
+			BottomCenter,
+			Center,
+			AlphaCentroid
+		};
+
 		CellsWidget(QWidget* parent = Q_NULLPTR);
 
 		void autoCreateCell();
@@ -17,6 +25,14 @@ namespace el
 		void showEditor();
 		void hideEditor();
 		void deleteSelected();
+		sizet dedupeCells();
+		sizet trimCells();
+		sizet autoPivots(PivotRule rule, uint alphaCut);
+		sizet autoHitboxes(uint alphaCut);
+		bool exportPadded(const fio::path& texturePath, int padding);
+		// Packs the cells into a new sheet without touching the atlas, applyRepack moves the cells once the sheet is saved
+		bool repackCells(const AtlasPackOptions& options, PixelBlock& packed, AtlasPackResult& result, float& occupancyBefore, float& occupancyAfter);
+		void applyRepack(const AtlasPackResult& result);
 
 		void onMouseMove();
 		void onKeyPress(QKeyEvent*);
@@ -63,6 +79,9 @@ namespace el
 		vec2 mCamPivot, mGrabPos;
 		Box mSelectRect;
 
+		bool readTexturePixels(PixelBlock& pixels);
+		vector<PixelRect> cellPixelRects(const PixelBlock& pixels);
+		vector<asset<CellHolder>> selectedOrAllHolders();
 		void safeClearSelection();
 		void connectMouseInput();
 		void connectList();
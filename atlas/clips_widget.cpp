@@ -4,10 +4,12 @@
 #include "../elqt/color_code.h"
 
 #include "util.h"
+#include "../elqt/extension/gl_resources.h"
 #include <tools/project.h>
 #include <common/algorithm.h>
 #include <common/line.h>
 #include <common/container.h>
+#include <tools/cell.h>
 #include <tools/clip.h>
 #include <tools/painter.h>
 #include <tools/material.h>
@@ -25,14 +27,19 @@ namespace el
 
 	ClipframeHolder::ClipframeHolder(
 		asset<Material> material, asset<Painter> painter, IButtonEvent* btnEvent
-	) : canvas(material, painter), button(btnEvent) {
+	) : canvas(material, painter), button(btnEvent), index(0) {
 	}
 
-	void ClipframeHolder::reshape(asset<Clip> clip) {
+	bool ClipframeHolder::reshape(asset<Clip> clip, ThumbnailCache& thumbs) {
 		assert(index < clip->cells.size());
-		auto cell = clip->cells.at(index);
-		if (cell)
-			canvas.recalc(cell);
+		auto next = clip->cells.at(index);
+		if (next != cell) {
+			cell = next;
+			auto thumb = thumbs.thumbnail(cell);
+			if (thumb)
+				canvas.recalc(thumb);
+			return true;
+		} return false;
 	}
 
 #define cReelFrameSize 100
@@ -42,10 +49,16 @@ namespace el
 		canvas.bounds = aabb(index * cReelFrameSize, -cReelFrameSize, index * cReelFrameSize + cReelFrameSize, -15);
 	}
 
-	ClipsWidget::ClipsWidget(QWidget* parent) : mPaused(false), mClip(asset<Clip>()), mSuppressScroll(false), mSuppressSelect(false), mSuppressSpinbox(false) {
+	ClipsWidget::ClipsWidget(QWidget* parent) : mPaused(false), mClip(asset<Clip>()), mSuppressScroll(false), mSuppressSelect(false), mSuppressSpinbox(false), mReelDirty(true), mReelLength(0), mFrame(0), mGridMode(false) {
 		ui.setupUi(this);
 		ui.scroll->setEnabled(false);
 
+		mLabel = new QLabel(ui.view);
+		mLabel->setStyleSheet("QLabel { color: white; background-color: rgba(0, 0, 0, 140); padding: 3px; }");
+		mLabel->setAttribute(Qt::WA_TransparentForMouseEvents);
+		mLabel->move(6, 6);
+		mLabel->hide();
+
 		connect(ui.scroll, &QScrollBar::valueChanged, [&](int value) {
 			if (mClip.clip() && !mSuppressScroll) {
 				mReelCamTarget.toX(value);
@@ -57,6 +70,21 @@ namespace el
 
 		connectView();
 		connectReel();
+
+		sig_Modified.connect([&]() {
+			if (mGridMode)
+				layoutGrid();
+		});
+
+		gEditorMemory.addReporter(this, [&](vector<MemoryUsage>& rows) {
+			auto holders = mReelSlots.size() + mReelPool.size();
+			if (holders > 0) {
+				rows.push_back({ "Clips", "Reel frame holders (" + std::to_string(mReelSlots.size()) + " visible, "
+					+ std::to_string(mReelPool.size()) + " parked)", holders * sizeof(ClipframeHolder), 0, false });
+			}
+			if (mGridTiles.size() > 0)
+				rows.push_back({ "Clips", "Grid preview tiles (" + std::to_string(mGridTiles.size()) + ")", mGridTiles.capacity() * sizeof(ClipPreviewTile), 0, false });
+		});
 	}
 
 	void ClipsWidget::connectView() {
@@ -73,7 +101,9 @@ namespace el
 
 		ui.view->sig_Paint.connect([&]() {
 			auto clip = mClip.clip();
-			if (clip && mClipSprite.cell() != asset<Cell>()) {
+			if (mGridMode) {
+				paintGrid();
+			} else if (clip && mClipSprite.cell() != asset<Cell>()) {
 				auto width = ui.view->width();
 				auto height = ui.view->height();
 				updateViewport(-width / 2, width / 2, -height / 2, height / 2);
@@ -86,6 +116,11 @@ namespace el
 
 				mViewShapes->draw();
 				mViewPainter->paint();
+			}
+
+			// The reel only needs a repaint when the playhead actually moves to another frame
+			if (clip && mClip.frame() != mFrame) {
+				mFrame = mClip.frame();
 				ui.reel->update();
 			}
 		});
@@ -152,19 +187,13 @@ namespace el
 			if (clip) {
 				updateViewport(0, ui.reel->width(), -ui.reel->height(), 0);
 
-				// batch reel frame
-				auto view = gProject.view<ClipframeHolder>();
-				sizet i = 0;
-				for (asset<ClipframeHolder> holder : view) {
-					holder->canvas.batch();
-					auto x = i * cReelFrameSize + cReelFrameSize;
-					mReelShapes->line.batchline(line(x, 0, x, -cReelFrameSize), color8(255, 255, 255, 255));
-					i++;
-				}
-				mReelShapes->line.batchline(line(0, -14, cReelFrameSize * i, -14), color8(255, 255, 255, 255));
-				mReelShapes->fill.batchAABB(aabb(0, -14, cReelFrameSize * i, 0), color8(255, 255, 255, 80));
-				if (mClipSprite.cell() != asset<Cell>() && view.size() > 0) {
+				syncReel();
+				if (mReelDirty)
+					rebatchReelStatic();
+
+				if (mClipSprite.cell() != asset<Cell>() && clip->cells.size() > 0) {
 					auto frame = mClip.frame();
+					mFrame = frame;
 					auto rect = aabb(frame * cReelFrameSize + 2, -cReelFrameSize + 2, frame * cReelFrameSize + cReelFrameSize - 2, -2);
 					rect.b = -14 +2;
 					mReelShapes->line.batchAABB(rect, color8(255, 0, 0, 255));
@@ -214,6 +243,7 @@ namespace el
 
 
 				mReelPainter->paint();
+				mReelStaticShapes->draw();
 				mReelShapes->draw();
 			}
 		});
@@ -296,10 +326,8 @@ namespace el
 					if (mMovingSide >= 0 && mClip.clip()) {
 						auto index = mHeld->index;
 						el_vector::swapshift(mClip.clip()->cells, index, mMovingSide);
-						recreateReel();
-
-						auto& view = mClip.clip()->cells;
-						mHovering = (index < view.size()) ? view[index] : NullEntity;
+						syncReel();
+						mHovering = reelHolder(index);
 
 						sig_Modified.invoke();
 					}
@@ -320,7 +348,7 @@ namespace el
 							auto prev = frames.at(mHeld->index);
 							if (prev != cell) {
 								frames.at(mHeld->index) = cell;
-								mHeld->reshape(clip);
+								syncReel();
 								sig_Modified.invoke();
 								ui.view->update();
 							}
@@ -354,10 +382,9 @@ namespace el
 					assert(index < frames.size());
 
 					frames.erase(frames.begin() + index);
-					recreateReel();
-
-					auto& view = mClip.clip()->cells;
-					mHovering = (index < view.size()) ? view[index] : NullEntity;
+					mHeld = NullEntity;
+					syncReel();
+					mHovering = reelHolder(index);
 					sig_Modified.invoke();
 				}
 
@@ -384,13 +411,13 @@ namespace el
 
 	void ClipsWidget::updateAllCanvasButton() {
 		mHovering = NullEntity;
-		auto view = gProject.view<ClipframeHolder>();
-		if (view.size() > 0) {
+		syncReel();
+		if (mReelSlots.size() > 0) {
 			auto pos = gMouse.currentPosition();
 			pos.x += ui.reel->width() / 2.0f + mReelCam->position().x;
 			pos.y -= ui.reel->height() / 2.0f; // Minused because of updateViewport in ui.reel->sig_Paint
 
-			for (asset<ClipframeHolder> holder : view) {
+			for (auto holder : mReelSlots) {
 				auto hit = holder->canvas.bounds.contains(pos);
 				holder->button.update(holder, hit);
 			}
@@ -436,13 +463,146 @@ namespace el
 	}
 
 	void ClipsWidget::animLoop() {
-		if (!mPaused) {
-			if (mClip.clip())
-				mClip.step(mClipSprite);
+		if (mPaused) {
+			mPlayback.resync();
+			return;
+		}
+
+		// Every frame that fell due is stepped, only the last one gets shown
+		auto due = mPlayback.advance();
+		if (due > 0) {
+			if (mClip.clip()) {
+				for (uint i = 0; i < due; i++)
+					mClip.step(mClipSprite);
+			}
+			for (auto& tile : mGridTiles) {
+				for (uint i = 0; i < due; i++)
+					tile.anim.step(tile.sprite);
+			}
 			ui.view->update();
+
+			if (mLabel->isVisible())
+				updateTimingOverlay();
+		}
+	}
+
+	void ClipsWidget::setFrameRate(int fps) {
+		mPlayback.setRate((float)fps);
+		updateTimingOverlay();
+	}
+
+	void ClipsWidget::setGridPreview(bool enabled) {
+		mGridMode = enabled;
+		recreateGrid();
+		ui.view->update();
+	}
+
+	void ClipsWidget::recreateGrid() {
+		mGridTiles.clear();
+		if (mGridMode && mViewPainter && gAtlasUtil.currentAtlas && gAtlasUtil.currentAtlas.has<AssetLoaded>()) {
+			auto& clips = gAtlasUtil.currentAtlas.get<AtlasMeta>().cliporder;
+			mGridTiles.reserve(clips.size());
+			for (asset<Clip> clip : clips) {
+				mGridTiles.emplace_back(clip);
+				auto& tile = mGridTiles.back();
+				tile.sprite.material = gAtlasUtil.currentMaterial;
+				tile.sprite.painter = mViewPainter;
+			}
+		}
+		layoutGrid();
+	}
+
+	void ClipsWidget::layoutGrid() {
+		if (mGridTiles.empty())
+			return;
+
+		// Every slot fits the union of all frames around their pivot, so silhouettes line up across clips
+		aabb extent(0.0f, 0.0f, 0.0f, 0.0f);
+		for (auto& tile : mGridTiles) {
+			for (auto cell : tile.anim.clip()->cells) {
+				if (!cell)
+					continue;
+				auto& cm = cell.get<CellMeta>();
+				extent.l = min(extent.l, (float)-cm.oX);
+				extent.r = max(extent.r, (float)(-cm.oX + (int)cm.w));
+				extent.t = max(extent.t, (float)cm.oY);
+				extent.b = min(extent.b, (float)(cm.oY - (int)cm.h));
+			}
+		}
+
+		const float margin = 16.0f;
+		auto pitchX = extent.r - extent.l + margin;
+		auto pitchY = extent.t - extent.b + margin;
+		auto columns = (sizet)ceil(sqrt((double)mGridTiles.size()));
+		auto rows = (mGridTiles.size() + columns - 1) / columns;
+		auto left = -pitchX * columns / 2.0f;
+		auto top = pitchY * rows / 2.0f;
+
+		for (sizet i = 0; i < mGridTiles.size(); i++) {
+			auto& tile = mGridTiles[i];
+			auto x = left + pitchX * (i % columns);
+			auto y = top - pitchY * (i / columns);
+			tile.slot = aabb(x, y - pitchY, x + pitchX, y);
+			tile.position = vec2(x + margin / 2.0f - extent.l, y - margin / 2.0f - extent.t);
+		}
+	}
+
+	void ClipsWidget::paintGrid() {
+		auto width = ui.view->width();
+		auto height = ui.view->height();
+		updateViewport(-width / 2, width / 2, -height / 2, height / 2);
+
+		// Tiles outside the camera never reach the painter
+		auto center = mViewCam->position();
+		auto scale = mViewCam->scale();
+		auto halfW = width / 2.0f * scale.x;
+		auto halfH = height / 2.0f * scale.y;
+		aabb visible(center.x - halfW, center.y - halfH, center.x + halfW, center.y + halfH);
+
+		vector<ClipPreviewTile*> shown;
+		for (auto& tile : mGridTiles) {
+			auto& slot = tile.slot;
+			if (!(slot.r < visible.l || slot.l > visible.r || slot.t < visible.b || slot.b > visible.t))
+				shown.push_back(&tile);
+		}
+
+		// Zooming out over a large atlas grows the painter, it shrinks again once the view stays zoomed in
+		auto needed = shown.size() * QElangGLResources::cSpriteVertices;
+		if (gEditorGL.reserve(mViewPainter, needed) || gEditorGL.trim(mViewPainter, needed)) {
+			mClipSprite.painter = mViewPainter;
+			for (auto& tile : mGridTiles)
+				tile.sprite.painter = mViewPainter;
+		}
+
+		for (auto tile : shown) {
+			mViewShapes->line.batchAABB(tile->slot, color8(255, 255, 255, 40));
+			if (tile->sprite.cell() != asset<Cell>()) {
+				tile->sprite.recalc(tile->position);
+				tile->sprite.batch();
+			}
+		}
+
+		mViewShapes->draw();
+		mViewPainter->paint();
+	}
+
+	void ClipsWidget::setTimingOverlay(bool visible) {
+		mLabel->setVisible(visible);
+		if (visible) {
+			mPlayback.reset();
+			updateTimingOverlay();
 		}
 	}
 
+	void ClipsWidget::updateTimingOverlay() {
+		mLabel->setText(QString("%1 / %2 fps   jitter %3 ms   dropped %4")
+			.arg(mPlayback.fps(), 0, 'f', 1)
+			.arg(mPlayback.rate(), 0, 'f', 0)
+			.arg(mPlayback.jitterMs(), 0, 'f', 2)
+			.arg(mPlayback.dropped()));
+		mLabel->adjustSize();
+	}
+
 	void ClipsWidget::createClip() {
 		assert(gAtlasUtil.currentAtlas);
 
@@ -468,6 +628,8 @@ namespace el
 			mSuppressSelect = false;
 
 			list.setCurrentItem(item);
+			if (mGridMode)
+				recreateGrid();
 			sig_Modified.invoke();
 		}
 	}
@@ -497,6 +659,8 @@ namespace el
 			list->setCurrentRow(-1);
 			list->setCurrentRow(row);
 
+			if (mGridMode)
+				recreateGrid();
 			sig_Modified.invoke();
 		}
 	}
@@ -515,11 +679,8 @@ namespace el
 				}
 				frames.emplace_back(cell);
 
-				auto holder = gProject.make<ClipframeHolder>(gAtlasUtil.currentMaterial, mReelPainter, this);
-				holder->reorder(size);
-				holder->reshape(item->clip);
-
 				syncScroll();
+				syncReel();
 				ui.reel->update();
 				sig_Modified.invoke();
 			}
@@ -527,11 +688,19 @@ namespace el
 	}
 
 	void ClipsWidget::updateOnAtlasLoad() {
+		mThumbs.invalidate();
 		recreateList();
 	}
 
+	void ClipsWidget::refreshFrames() {
+		recreateReel();
+		recreateGrid();
+		ui.view->update();
+	}
+
 	void ClipsWidget::recreateList() {
 		if (gAtlasUtil.currentAtlas.has<AssetLoaded>()) {
+			EL_TRACE_SCOPE("ClipsWidget::recreateList");
 			mSuppressSelect = true;
 			auto& list = *gAtlasUtil.clipList;
 			auto row = list.currentRow();
@@ -554,6 +723,8 @@ namespace el
 
 			list.setCurrentRow(row);
 			recreateReel();
+			if (mGridMode)
+				recreateGrid();
 		}
 	}
 
@@ -573,21 +744,118 @@ namespace el
 	}
 
 	void ClipsWidget::recreateReel() {
+		EL_TRACE_SCOPE("recreateReel");
+		// Cells may have been remolded elsewhere, so every visible canvas is recalculated once
+		for (auto holder : mReelSlots)
+			holder->invalidate();
+		mReelDirty = true;
+
+		// Only tiles of cells moved or resized since the last sync are downsampled again
+		if (mReelCam) {
+			ui.reel->makeCurrent();
+			mThumbs.sync(gAtlasUtil.currentMaterial);
+		}
+
+		syncScroll();
+		syncReel();
+		ui.reel->update();
+	}
+
+	void ClipsWidget::syncReel() {
 		auto clip = mClip.clip();
-		auto view = gProject.view<ClipframeHolder>();
-		gProject.destroy(view.begin(), view.end());
+		sizet count = clip ? clip->cells.size() : 0;
+		sizet first = 0, last = 0;
+		if (count > 0 && mReelCam) {
+			auto left = max(0.0f, mReelCam->position().x);
+			first = min(count, (sizet)(left / cReelFrameSize));
+			last = min(count, (sizet)((left + ui.reel->width()) / cReelFrameSize) + 1);
+		}
 
-		if (clip) {
-			auto size = clip->cells.size();
-			for (sizet i = 0; i < size; i++) {
-				asset<ClipframeHolder> holder = gProject.make<ClipframeHolder>(gAtlasUtil.currentMaterial, mReelPainter, this);
-				holder->reorder(i);
-				holder->reshape(clip);
+		// The held frame stays live while it is dragged out of view
+		for (sizet i = 0; i < mReelSlots.size();) {
+			auto holder = mReelSlots[i];
+			auto index = holder->index;
+			if (index < count && ((index >= first && index < last) || holder == mHeld)) {
+				i++;
+			} else {
+				mReelSlots[i] = mReelSlots.back();
+				mReelSlots.pop_back();
+				parkReelHolder(holder);
+				mReelDirty = true;
 			}
 		}
 
-		syncScroll();
-		ui.reel->update();
+		for (sizet index = first; index < last; index++) {
+			if (!reelHolder(index)) {
+				asset<ClipframeHolder> holder;
+				if (mReelPool.size() > 0) {
+					holder = mReelPool.back();
+					mReelPool.pop_back();
+				} else {
+					holder = gProject.make<ClipframeHolder>(mThumbs.material(), mReelPainter, this);
+				}
+				holder->reorder(index);
+				holder->invalidate();
+				mReelSlots.push_back(holder);
+				mReelDirty = true;
+			}
+		}
+
+		// Only frames whose cell actually changed get their canvas recalculated
+		for (auto holder : mReelSlots) {
+			if (holder->reshape(clip, mThumbs))
+				mReelDirty = true;
+		}
+
+		if (count != mReelLength) {
+			mReelLength = count;
+			mReelDirty = true;
+		}
+	}
+
+	void ClipsWidget::rebatchReelStatic() {
+		// Only the visible window of frames is batched, so the painter follows the reel's width rather than the clip's length
+		auto needed = mReelSlots.size() * QElangGLResources::cSpriteVertices;
+		if (gEditorGL.reserve(mReelPainter, needed) || gEditorGL.trim(mReelPainter, needed)) {
+			for (auto holder : mReelSlots)
+				holder->canvas.painter = mReelPainter;
+			for (auto holder : mReelPool)
+				holder->canvas.painter = mReelPainter;
+		}
+
+		mReelPainter->forceUnlock();
+		mReelStaticShapes->line.forceUnlock();
+		mReelStaticShapes->fill.forceUnlock();
+
+		for (auto holder : mReelSlots) {
+			holder->canvas.batch();
+			auto x = holder->index * cReelFrameSize + cReelFrameSize;
+			mReelStaticShapes->line.batchline(line(x, 0, x, -cReelFrameSize), color8(255, 255, 255, 255));
+		}
+		auto length = cReelFrameSize * mReelLength;
+		mReelStaticShapes->line.batchline(line(0, -14, length, -14), color8(255, 255, 255, 255));
+		mReelStaticShapes->fill.batchAABB(aabb(0, -14, length, 0), color8(255, 255, 255, 80));
+
+		mReelPainter->flags |= ePainterFlags::LOCKED;
+		mReelStaticShapes->line.flags |= ePainterFlags::LOCKED;
+		mReelStaticShapes->fill.flags |= ePainterFlags::LOCKED;
+		mReelDirty = false;
+	}
+
+	void ClipsWidget::parkReelHolder(asset<ClipframeHolder> holder) {
+		if (holder.has<AtlasLastModifiedReelHolder>())
+			holder.remove<AtlasLastModifiedReelHolder>();
+		if (mHovering == holder)
+			mHovering = NullEntity;
+		holder->invalidate();
+		mReelPool.push_back(holder);
+	}
+
+	asset<ClipframeHolder> ClipsWidget::reelHolder(sizet index) {
+		for (auto holder : mReelSlots) {
+			if (holder->index == index)
+				return holder;
+		} return NullEntity;
 	}
 
 
@@ -636,13 +904,8 @@ namespace el
 			mViewCam = gProject.make<Camera>().add<EditorAsset>();
 			mViewCamTarget.to(vec3(0.0f, 0.0f, -1000.0f));
 
-			mViewPainter = gProject.make<Painter>("__el_editor_/shader/basic_sprite.vert", "__el_editor_/shader/texture_uv.frag",
-				32, mViewCam, Projection::eOrtho,
-				ePainterFlags::DEPTH_SORT | ePainterFlags::MULTI_MATERIAL | ePainterFlags::Z_CLEAR).add<EditorAsset>();
-			mViewPainter->init();
-
-			mViewShapes = new ShapeDebug2d;
-			mViewShapes->init(mViewCam);
+			mViewPainter = gEditorGL.acquireSpritePainter(QElangGLResources::cMinCapacity, mViewCam);
+			mViewShapes = gEditorGL.acquireShapes(mViewCam);
 			*mViewCam = mViewCamTarget;
 			setupCameraTween(mViewCamTween);
 		}
@@ -657,13 +920,12 @@ namespace el
 			mReelCam = gProject.make<Camera>().add<EditorAsset>();
 			mReelCamTarget.to(vec3(0.0f, 0.0f, -1000.0f));
 
-			mReelPainter = gProject.make<Painter>("__el_editor_/shader/basic_sprite.vert", "__el_editor_/shader/texture_uv.frag",
-				3000, mReelCam, Projection::eOrtho,
-				ePainterFlags::DEPTH_SORT | ePainterFlags::MULTI_MATERIAL | ePainterFlags::Z_CLEAR).add<EditorAsset>();
-			mReelPainter->init();
+			mReelPainter = gEditorGL.acquireSpritePainter(QElangGLResources::cMinCapacity, mReelCam);
+			mReelShapes = gEditorGL.acquireShapes(mReelCam);
+			mReelStaticShapes = gEditorGL.acquireShapes(mReelCam);
 
-			mReelShapes = new ShapeDebug2d;
-			mReelShapes->init(mReelCam);
+			mThumbs.persistDirectory = "../___gui/dat/thumbs";
+			mThumbs.init();
 
 			*mReelCam = mReelCamTarget;
 			setupCameraTween(mReelCamTween);
@@ -671,7 +933,7 @@ namespace el
 	}
 
 	void ClipsWidget::connectList() {
-		connect(gAtlasUtil.clipList, &QListExtension::currentRowChanged, [&]() {
+		connect(gAtlasUtil.clipList, &QListExtension::currentRowChanged, this, [&]() {
 			if (isVisible() && !mSuppressSelect) {
 				ClipItem* item = reinterpret_cast<ClipItem*>(gAtlasUtil.clipList->currentItem());
 				if (item && item->clip) {
@@ -704,14 +966,14 @@ namespace el
 			}
 			});
 
-		connect(gAtlasUtil.clipList->model(), &QAbstractItemModel::rowsMoved, [&]() {
+		connect(gAtlasUtil.clipList->model(), &QAbstractItemModel::rowsMoved, this, [&]() {
 			if (isVisible() && !mSuppressSelect) {
 				reorderClipsAccordingToList();
 				sig_Modified.invoke();
 			}
 			});
 
-		connect(gAtlasUtil.clipList->itemDelegate(), &QAbstractItemDelegate::commitData, [&](QWidget* pLineEdit) {
+		connect(gAtlasUtil.clipList->itemDelegate(), &QAbstractItemDelegate::commitData, this, [&](QWidget* pLineEdit) {
 			auto atlas = gAtlasUtil.currentAtlas;
 			if (isVisible() && atlas.has<AssetLoaded>()) {
 				ClipItem* item = reinterpret_cast<ClipItem*>(gAtlasUtil.clipList->currentItem());
@@ -733,6 +995,32 @@ namespace el
 		});
 	}
 
+	ClipsWidget::~ClipsWidget() {
+		gEditorMemory.removeReporter(this);
+		if (mReelCam) {
+			ui.reel->makeCurrent();
+			for (auto holder : mReelSlots)
+				holder.destroy();
+			for (auto holder : mReelPool)
+				holder.destroy();
+			mReelSlots.clear();
+			mReelPool.clear();
+			mThumbs.release();
+			gEditorGL.release(mReelPainter);
+			gEditorGL.release(mReelShapes);
+			gEditorGL.release(mReelStaticShapes);
+			mReelCam.destroy();
+		}
+
+		if (mViewCam) {
+			ui.view->makeCurrent();
+			mGridTiles.clear();
+			gEditorGL.release(mViewPainter);
+			gEditorGL.release(mViewShapes);
+			mViewCam.destroy();
+		}
+	}
+
 	void ClipsWidget::showEditor() {
 		gAtlasUtil.clipList->show();
 		recreateList();
@@ -1,6 +1,8 @@
 #pragma once
 #include <uic/ui_clips_widget.h>
 #include "../elqt/extension/view.h"
+#include "thumbnail_cache.h"
+#include "playback_clock.h"
 
 #include <tools/camera.h>
 #include <common/random.h>
@@ -24,10 +26,25 @@ namespace el
 		Canvas<SpriteVertex> canvas;
 		Button button;
 		sizet index;
+		asset<Cell> cell;
 
 		ClipframeHolder(asset<Material> material, asset<Painter> painter, IButtonEvent* btnEvent);
-		void reshape(asset<Clip> clip);
+		// Recalculates the canvas from the cell's thumbnail only when the frame at index now holds a different cell,
+		// returns whether it did
+		bool reshape(asset<Clip> clip, ThumbnailCache& thumbs);
 		void reorder(sizet index_);
+		void invalidate() { cell = asset<Cell>(); }
+	};
+
+	struct ClipPreviewTile
+	{
+		ClipAnimation anim;
+		Sprite sprite;
+		Position position;
+		// Slot of the tile in the grid, the sprite's pivot sits inside it
+		aabb slot;
+
+		ClipPreviewTile(asset<Clip> clip) : anim(clip) {}
 	};
 
 	struct ClipsWidget : public QWidget, public IButtonEvent
@@ -43,10 +60,14 @@ namespace el
 		Q_OBJECT
 	public:
 		ClipsWidget(QWidget* parent = Q_NULLPTR);
+		virtual ~ClipsWidget();
 
 		void showEditor();
 		void hideEditor();
 		void animLoop();
+		void setFrameRate(int fps);
+		void setTimingOverlay(bool visible);
+		void setGridPreview(bool enabled);
 		void recenterCamera();
 		void loop();
 
@@ -55,6 +76,8 @@ namespace el
 		void addFrame();
 
 		void updateOnAtlasLoad();
+		// Rebuilds the reel and grid after clip frames were remapped outside this widget
+		void refreshFrames();
 		void onKeyPress(QKeyEvent*);
 		void onKeyRelease(QKeyEvent*);
 
@@ -69,11 +92,19 @@ namespace el
 		void safeCreateFrameObjects();
 		void recreateList();
 		void recreateReel();
+		void recreateGrid();
+		void layoutGrid();
+		void paintGrid();
+		void syncReel();
+		void rebatchReelStatic();
+		void parkReelHolder(asset<ClipframeHolder> holder);
+		asset<ClipframeHolder> reelHolder(sizet index);
 		void reorderClipsAccordingToList();
 		void updateAllCanvasButton();
 		void connectList();
 		void syncScroll();
 		void updateCursor();
+		void updateTimingOverlay();
 		vec2 screenToReel();
 
 		// Inherited via IButtonEvent
@@ -101,11 +132,20 @@ namespace el
 		ClipAnimation mClip;
 		Sprite mClipSprite;
 		Position mClipPosition;
-
-		ShapeDebug2d* mReelShapes;
+		// Every clip of the atlas playing side by side, batched into mViewPainter
+		vector<ClipPreviewTile> mGridTiles;
+		bool mGridMode;
+
+		// Frames, separators and header are batched once into locked painters, mReelShapes only holds the overlay
+		ShapeDebug2d* mReelShapes, * mReelStaticShapes;
+		bool mReelDirty;
+		sizet mReelLength;
+		ThumbnailCache mThumbs;
 		QLabel* mLabel;
 		
 		asset<ClipframeHolder> mHovering, mHeld;
+		// Holders exist only for frames inside the visible reel window, parked ones are reused
+		vector<asset<ClipframeHolder>> mReelSlots, mReelPool;
 		eState mState;
 		asset<Painter> mReelPainter;
 		asset<Camera> mReelCam;
@@ -113,6 +153,8 @@ namespace el
 		Camera mReelCamTarget;
 
 		bool mPaused, mSuppressSelect, mSuppressSpinbox;
+		PlaybackClock mPlayback;
+		// Frame the reel playhead was last drawn at
 		uint32 mFrame;
 
 	};
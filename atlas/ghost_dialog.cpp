@@ -8,13 +8,20 @@
 #include <tools/texture.h>
 #include <tools/atlas.h>
 #include <tools/material.h>
+#include <QDoubleSpinBox>
+#include <QFormLayout>
+#include <QColorDialog>
 
 namespace el
 {
 
 	void ElangAtlasGhostData::createInternalAssets() {
-		if (!mExternal)
-			gAtlasUtil.makeEmptyMaterial("__editor_ghost_material_", mExternal, mExternalAtlas);
+		if (!mExternal) {
+			if (!gAtlasUtil.ghostMaterial)
+				gAtlasUtil.makeEmptyMaterial("__editor_ghost_material_", gAtlasUtil.ghostMaterial, gAtlasUtil.ghostAtlas);
+			mExternal = gAtlasUtil.ghostMaterial;
+			mExternalAtlas = gAtlasUtil.ghostAtlas;
+		}
 	}
 
 	ElangAtlasGhostDialog::ElangAtlasGhostDialog(ElangAtlasGhostData & data, QWidget * parent)
@@ -26,6 +33,7 @@ namespace el
 		ui.posBox->setDisabled(true);
 		ui.indexBox->setDisabled(true);
 		mData.createInternalAssets();
+		setupOnionBox();
 
 		switch (mData.type) {
 			case ElangAtlasGhostData::eType::NONE: ui.noneRadio->setChecked(true); break;
@@ -127,6 +135,47 @@ namespace el
 		});
 	}
 
+	void ElangAtlasGhostDialog::setupOnionBox() {
+		QGroupBox* box = new QGroupBox("Onion Skin", this);
+		QFormLayout* form = new QFormLayout(box);
+
+		QDoubleSpinBox* alpha = new QDoubleSpinBox(box);
+		alpha->setRange(0.0, 1.0);
+		alpha->setSingleStep(0.05);
+		alpha->setValue(mData.onionAlpha);
+		form->addRow("Alpha", alpha);
+		connect(alpha, &QDoubleSpinBox::valueChanged, [&](double value) { mData.onionAlpha = (float)value; });
+
+		// Anything under 1 costs one paint per layer instead of one per side
+		QDoubleSpinBox* falloff = new QDoubleSpinBox(box);
+		falloff->setRange(0.05, 1.0);
+		falloff->setSingleStep(0.05);
+		falloff->setValue(mData.onionFalloff);
+		falloff->setToolTip("Alpha multiplier for every layer past the nearest. 1 draws each side in a single pass");
+		form->addRow("Falloff", falloff);
+		connect(falloff, &QDoubleSpinBox::valueChanged, [&](double value) { mData.onionFalloff = (float)value; });
+
+		auto addTint = [&](const QString& label, vec4& tint) {
+			QPushButton* button = new QPushButton(box);
+			auto paint = [button](const vec4& color) {
+				button->setStyleSheet(QString("background-color: %1").arg(QColor::fromRgbF(color.r, color.g, color.b).name()));
+			};
+			paint(tint);
+			form->addRow(label, button);
+			connect(button, &QPushButton::clicked, [this, &tint, paint]() {
+				auto color = QColorDialog::getColor(QColor::fromRgbF(tint.r, tint.g, tint.b), this, "Onion Tint");
+				if (color.isValid()) {
+					tint = vec4((float)color.redF(), (float)color.greenF(), (float)color.blueF(), tint.a);
+					paint(tint);
+				}
+			});
+		};
+		addTint("Previous tint", mData.onionPrevTint);
+		addTint("Next tint", mData.onionNextTint);
+
+		ui.verticalLayout_5->addWidget(box);
+	}
+
 	void ElangAtlasGhostDialog::syncUIWithData() {
 		ui.posBox->setDisabled(mData.type == ElangAtlasGhostData::eType::NONE);
 		ui.indexBox->setDisabled(mData.type == ElangAtlasGhostData::eType::NONE || mData.type == ElangAtlasGhostData::eType::PREVIOUS);
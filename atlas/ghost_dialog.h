@@ -26,7 +26,9 @@ namespace el
 			FRONT
 		};
 
-		ElangAtlasGhostData() : type(eType::NONE), order(eOrder::BACK), cell(NullEntity), material(NullEntity) {};
+		ElangAtlasGhostData() : type(eType::NONE), order(eOrder::BACK), cell(NullEntity), material(NullEntity),
+			onionDepth(0), onionFromClip(false), onionAlpha(0.35f), onionFalloff(1.0f),
+			onionPrevTint(1.0f, 0.55f, 0.55f, 1.0f), onionNextTint(0.55f, 0.75f, 1.0f, 1.0f) {};
 
 		eType type;
 		eOrder order;
@@ -34,6 +36,14 @@ namespace el
 		asset<Material> material;
 		asset<Atlas> atlas;
 
+		// Onion skin frames drawn on each side of the current cell, taken from the cell list or the selected clip.
+		// The nearest layer gets onionAlpha, every further one is multiplied by onionFalloff.
+		// The tint is a painter uniform, so each side is one paint at the default falloff of 1 and one per layer below it
+		uint onionDepth;
+		bool onionFromClip;
+		float onionAlpha, onionFalloff;
+		vec4 onionPrevTint, onionNextTint;
+
 	private:
 		void createInternalAssets();
 		asset<Material> mExternal;
@@ -49,6 +59,7 @@ namespace el
 	private:
 		void syncUIWithData();
 		void syncCellOnly();
+		void setupOnionBox();
 		bool suppressSelect;
 		ElangAtlasGhostData& mData;
 		bool mConfirmed;
@@ -1,8 +1,14 @@
 #include "atlas_editor.h"
+#include "../elqt/extension/gl_resources.h"
+#include "../elqt/extension/trace.h"
 #include <QtWidgets/QApplication>
 
 int main(int argc, char *argv[])
 {
+    el::Trace::initFromEnvironment();
+    el::QElangGLResources::enableShaderDiskCache("../___gui/dat/shader_cache");
+    // Textures are loaded once and drawn from every view's context
+    QCoreApplication::setAttribute(Qt::AA_ShareOpenGLContexts);
     QApplication a(argc, argv);
     el::AtlasEditor w(nullptr, false);
     w.show();
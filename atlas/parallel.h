@@ -0,0 +1,38 @@
+#pragma once
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace el
+{
+	// Runs func(i) for every i in [0, count) across a small pool of worker threads.
+	// The calling thread takes part in the work, and the call returns only after every index is done.
+	// func must not touch gProject or any GL state; collect results per index and apply them afterwards.
+	template<typename Func>
+	void parallelFor(size_t count, Func&& func, unsigned threads = 0) {
+		if (threads == 0)
+			threads = std::thread::hardware_concurrency();
+		if (threads > count)
+			threads = (unsigned)count;
+
+		if (threads <= 1) {
+			for (size_t i = 0; i < count; i++)
+				func(i);
+			return;
+		}
+
+		std::atomic<size_t> next(0);
+		auto worker = [&]() {
+			for (size_t i = next++; i < count; i = next++)
+				func(i);
+		};
+
+		std::vector<std::thread> pool;
+		pool.reserve(threads - 1);
+		for (unsigned t = 1; t < threads; t++)
+			pool.emplace_back(worker);
+		worker();
+		for (auto& thread : pool)
+			thread.join();
+	}
+}
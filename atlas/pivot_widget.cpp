@@ -1,6 +1,9 @@
 #include <elqtpch.h>
 #include "pivot_widget.h"
 #include "cells_widget.h"
+#include "pixel_ops.h"
+#include "parallel.h"
+#include "../elqt/extension/gl_resources.h"
 
 #include <common/algorithm.h>
 #include <common/line.h>
@@ -9,13 +12,15 @@
 #include <tools/controls.h>
 #include <tools/texture.h>
 #include <tools/atlas.h>
+#include <tools/clip.h>
 #include <apparatus/ui.h>
 #include <apparatus/asset_loader.h>
+#include <unordered_map>
 
 namespace el
 {
 	PivotView::PivotView(QWidget* parent)
-		: QElangView(parent), mCreateState(eState::Moving)
+		: QElangView(parent), mCreateState(eState::Moving), mGhostPickerUses(0)
 	{
 		//setFocusPolicy(Qt::StrongFocus);
 		setupCameraTween(mMainCamTween);
@@ -28,9 +33,10 @@ namespace el
 
 	void PivotView::release() {
 		if (mMainCam) {
+			makeCurrent();
 			mMainCam.destroy();
-			mPainter.destroy();
-			delete mHighlighter;
+			gEditorGL.release(mPainter);
+			gEditorGL.release(mHighlighter);
 		}
 	}
 	void PivotView::snapCamera() {
@@ -71,39 +77,35 @@ namespace el
 			mMainCam->to(vec3(0.0f, 0.0f, -1000.0f));
 			snapCamera();
 
-			mPainter = gProject.make<Painter>("__el_editor_/shader/basic_sprite.vert", "__el_editor_/shader/texture_uv.frag", 
-				32, mMainCam, Projection::eOrtho,
-				ePainterFlags::DEPTH_SORT | ePainterFlags::MULTI_MATERIAL | ePainterFlags::Z_CLEAR).add<EditorAsset>();
-			mPainter->init();
-
-			mHighlighter = new ShapeDebug2d;
-			mHighlighter->init(mMainCam);
+			mPainter = gEditorGL.acquireSpritePainter(QElangGLResources::cMinCapacity, mMainCam);
+			mHighlighter = gEditorGL.acquireShapes(mMainCam);
 		}
 		
 		mCellSprite = { gAtlasUtil.currentMaterial, mPainter, "" };
 		mGhostSprite = { 0, mPainter, "" };
 	}
 
-	void PivotView::paintGhostCell() {
-		bool none = false;
+	bool PivotView::resolveGhost(asset<Cell>& cell, asset<Material>& material) {
 		switch (mGhostData.type) {
-		case ElangAtlasGhostData::eType::NONE: none = true; break;
+		case ElangAtlasGhostData::eType::NONE: return false;
 		case ElangAtlasGhostData::eType::PREVIOUS:
-			{
-				CellItem* item = reinterpret_cast<CellItem*>(gAtlasUtil.cellList->item(gAtlasUtil.cellList->currentRow() - 1));
-				if (item) {
-					mGhostSprite.material = gAtlasUtil.currentMaterial;
-					mGhostSprite.setCell(item->text().toStdString());
-				} else none = true;
-			}
+			cell = cellAtRow(gAtlasUtil.cellList->currentRow() - 1);
+			material = gAtlasUtil.currentMaterial;
 			break;
 		default:
-			mGhostSprite.material = mGhostData.material;
-			mGhostSprite.setCell(mGhostData.cell);
+			cell = mGhostData.cell;
+			material = mGhostData.material;
 			break;
-		}
+		} return cell && material;
+	}
 
-		if (none) {
+	void PivotView::paintGhostCell() {
+		asset<Cell> cell;
+		asset<Material> material;
+		if (resolveGhost(cell, material)) {
+			mGhostSprite.material = material;
+			mGhostSprite.setCell(cell);
+		} else {
 			mGhostSprite.material = NullEntity;
 			mGhostSprite.setCell(asset<Cell>());
 		}
@@ -117,9 +119,212 @@ namespace el
 		}
 	}
 
+	void PivotView::collectOnionCells(vector<asset<Cell>>& prev, vector<asset<Cell>>& next) {
+		int depth = (int)mGhostData.onionDepth;
+		auto row = gAtlasUtil.cellList->currentRow();
+		if (!mGhostData.onionFromClip) {
+			for (int k = 1; k <= depth; k++) {
+				prev.push_back(cellAtRow(row - k));
+				next.push_back(cellAtRow(row + k));
+			}
+			return;
+		}
+
+		// Neighbours of the current cell's first appearance in the selected clip
+		ClipItem* item = reinterpret_cast<ClipItem*>(gAtlasUtil.clipList->currentItem());
+		if (!item || !item->clip)
+			return;
+		auto& frames = item->clip->cells;
+		auto current = std::find(frames.begin(), frames.end(), cellAtRow(row));
+		if (current == frames.end())
+			return;
+
+		int index = (int)(current - frames.begin());
+		for (int k = 1; k <= depth; k++) {
+			prev.push_back((index - k >= 0) ? frames[index - k] : asset<Cell>());
+			next.push_back((index + k < (int)frames.size()) ? frames[index + k] : asset<Cell>());
+		}
+	}
+
+	void PivotView::rebindPainter() {
+		mCellSprite.painter = mPainter;
+		mGhostSprite.painter = mPainter;
+		for (auto& sprite : mOnionSprites)
+			sprite.painter = mPainter;
+	}
+
+	void PivotView::paintOnionSkins() {
+		if (mGhostData.onionDepth == 0) {
+			// A painter grown for deep onion skins is given back once they stay off
+			if (gEditorGL.trim(mPainter, QElangGLResources::cSpriteVertices))
+				rebindPainter();
+			return;
+		}
+
+		vector<asset<Cell>> prev, next;
+		collectOnionCells(prev, next);
+
+		// Farthest layers first on each side. SpriteVertex has no colour, so the tint is the painter's uniform:
+		// consecutive layers sharing a colour go out in one paint, which is a single paint per side without falloff
+		vector<std::pair<asset<Cell>, vec4>> layers;
+		for (int side = 0; side < 2; side++) {
+			auto& cells = (side == 0) ? prev : next;
+			auto tint = (side == 0) ? mGhostData.onionPrevTint : mGhostData.onionNextTint;
+			for (int k = (int)cells.size() - 1; k >= 0; k--) {
+				if (cells[k]) {
+					tint.a = mGhostData.onionAlpha * pow(mGhostData.onionFalloff, (float)k);
+					layers.emplace_back(cells[k], tint);
+				}
+			}
+		}
+
+		while (mOnionSprites.size() < layers.size())
+			mOnionSprites.push_back({ gAtlasUtil.currentMaterial, mPainter, "" });
+
+		// Deep onion skins on one colour can outgrow the painter, which only ever holds a single paint's worth
+		auto needed = layers.size() * QElangGLResources::cSpriteVertices;
+		if (gEditorGL.reserve(mPainter, needed) || gEditorGL.trim(mPainter, needed))
+			rebindPainter();
+
+		sizet i = 0;
+		while (i < layers.size()) {
+			auto color = layers[i].second;
+			for (; i < layers.size() && layers[i].second == color; i++) {
+				auto& sprite = mOnionSprites[i];
+				sprite.material = gAtlasUtil.currentMaterial;
+				sprite.setCell(layers[i].first);
+				sprite.recalc(mCellPos);
+				sprite.batch();
+			}
+			mPainter->color = color;
+			mPainter->paint();
+		}
+	}
+
+	namespace
+	{
+		PixelRect cellPixelRect(const CellMeta& cm, const PixelBlock& pixels) {
+			return PixelRect((int)cm.x, (int)cm.y, (int)(cm.x + cm.w), (int)(cm.y + cm.h)).clipped(pixels.bounds());
+		}
+
+		// Moves the art by (dx, dy) pixels, y down, around a fixed pivot; the hitbox goes along with it
+		void shiftCellArt(asset<CellHolder> holder, int dx, int dy, const AtlasMeta& meta) {
+			auto& cm = holder.get<CellMeta>();
+			auto& hitbox = holder->hitbox;
+			if (hitbox.l != hitbox.r || hitbox.b != hitbox.t)
+				hitbox.move(vec2(dx, -dy));
+			cm.oX -= dx;
+			cm.oY -= dy;
+			holder->moldCellFromRect(holder, (int)meta.width, (int)meta.height);
+		}
+	}
+
+	bool PivotView::autoAlignToGhost(int radius) {
+		CellItem* item = reinterpret_cast<CellItem*>(gAtlasUtil.cellList->currentItem());
+		asset<Cell> ghost;
+		asset<Material> material;
+		if (!item || !item->holder || !resolveGhost(ghost, material) || !material->hasTexture())
+			return false;
+		if (!gAtlasUtil.currentMaterial || !gAtlasUtil.currentMaterial->hasTexture())
+			return false;
+
+		makeCurrent();
+		PixelBlock pixels, ghostPixels;
+		if (!pixels.loadFromTexture(gAtlasUtil.currentMaterial->textures[0]))
+			return false;
+		auto reference = &pixels;
+		if (material != gAtlasUtil.currentMaterial) {
+			if (!ghostPixels.loadFromTexture(material->textures[0]))
+				return false;
+			reference = &ghostPixels;
+		}
+
+		// Top-left pixels sit at (-oX, -oY) around the shared pivot, y down
+		auto& fixed = ghost.get<CellMeta>();
+		auto& moving = item->holder.get<CellMeta>();
+		int dx, dy;
+		alignAlpha(
+			extractAlpha(*reference, cellPixelRect(fixed, *reference)),
+			extractAlpha(pixels, cellPixelRect(moving, pixels)),
+			fixed.oX - moving.oX, fixed.oY - moving.oY, radius, dx, dy
+		);
+		if (dx == 0 && dy == 0)
+			return false;
+
+		shiftCellArt(item->holder, dx, dy, gAtlasUtil.currentAtlas.get<AtlasMeta>());
+		sig_Modified.invoke();
+		update();
+		return true;
+	}
+
+	sizet PivotView::autoAlignClip(int radius) {
+		ClipItem* item = reinterpret_cast<ClipItem*>(gAtlasUtil.clipList->currentItem());
+		if (!item || !item->clip || item->clip->cells.size() < 2 || !gAtlasUtil.currentMaterial || !gAtlasUtil.currentMaterial->hasTexture())
+			return 0;
+
+		makeCurrent();
+		PixelBlock pixels;
+		if (!pixels.loadFromTexture(gAtlasUtil.currentMaterial->textures[0]))
+			return 0;
+
+		auto frames = item->clip->cells;
+		auto count = frames.size();
+		vector<PixelRect> rects(count);
+		vector<int> pivotX(count), pivotY(count);
+		for (sizet i = 0; i < count; i++) {
+			auto& cm = frames[i].get<CellMeta>();
+			rects[i] = cellPixelRect(cm, pixels);
+			pivotX[i] = cm.oX;
+			pivotY[i] = cm.oY;
+		}
+
+		// Each frame is matched against the one before it as they are now, so every pair runs independently
+		vector<int> stepX(count, 0), stepY(count, 0);
+		parallelFor(count - 1, [&](sizet p) {
+			auto i = p + 1;
+			if (frames[i] == frames[i - 1])
+				return;
+			alignAlpha(
+				extractAlpha(pixels, rects[i - 1]), extractAlpha(pixels, rects[i]),
+				pivotX[i - 1] - pivotX[i], pivotY[i - 1] - pivotY[i], radius, stepX[i], stepY[i]
+			);
+		});
+
+		// Moves accumulate down the clip; a cell that shows up again keeps the move of its first appearance
+		std::unordered_map<Entity, std::pair<int, int>> moved;
+		int totalX = 0, totalY = 0;
+		moved[frames[0]] = { 0, 0 };
+		for (sizet i = 1; i < count; i++) {
+			auto first = moved.find(frames[i]);
+			if (first != moved.end()) {
+				totalX = first->second.first;
+				totalY = first->second.second;
+			} else {
+				totalX += stepX[i];
+				totalY += stepY[i];
+				moved[frames[i]] = { totalX, totalY };
+			}
+		}
+
+		auto& meta = gAtlasUtil.currentAtlas.get<AtlasMeta>();
+		sizet changed = 0;
+		for (auto& pair : moved) {
+			if (pair.second.first != 0 || pair.second.second != 0) {
+				shiftCellArt(asset<CellHolder>(pair.first), pair.second.first, pair.second.second, meta);
+				changed++;
+			}
+		}
+
+		if (changed > 0) {
+			sig_Modified.invoke();
+			update();
+		} return changed;
+	}
+
 	void PivotView::execGhostDialog() {
 		ElangAtlasGhostDialog dialog(mGhostData);
 		dialog.exec();
+		update();
 	}
 
 	void PivotView::moveCurrentCell() {
@@ -165,8 +370,9 @@ namespace el
 			if (item) {
 				if (mGhostData.order == ElangAtlasGhostData::eOrder::BACK)
 					paintGhostCell();
+				paintOnionSkins();
 
-				mCellSprite.setCell(item->text().toStdString());
+				mCellSprite.setCell(cellAtRow(gAtlasUtil.cellList->currentRow()));
 				mCellSprite.recalc(mCellPos);
 				mCellSprite.batch();
 
@@ -383,10 +589,40 @@ namespace el
 	}
 
 	void PivotView::connectList() {
-		connect(gAtlasUtil.cellList, &QListExtension::currentRowChanged, [&]() {
+		connect(gAtlasUtil.cellList, &QListExtension::currentRowChanged, this, [&]() {
 			//setFocus();
 			update();
 		});
+
+		auto model = gAtlasUtil.cellList->model();
+		auto invalidate = [&]() { mRowCells.clear(); };
+		connect(model, &QAbstractItemModel::rowsInserted, this, invalidate);
+		connect(model, &QAbstractItemModel::rowsRemoved, this, invalidate);
+		connect(model, &QAbstractItemModel::rowsMoved, this, invalidate);
+		connect(model, &QAbstractItemModel::modelReset, this, invalidate);
+		connect(model, &QAbstractItemModel::dataChanged, this, invalidate);
+	}
+
+	asset<Cell> PivotView::cellAtRow(int row) {
+		auto& list = *gAtlasUtil.cellList;
+		if (row < 0 || row >= list.count())
+			return asset<Cell>();
+		if (mRowCells.size() != (sizet)list.count())
+			mRowCells.assign(list.count(), asset<Cell>());
+
+		auto& cell = mRowCells[row];
+		if (!cell) {
+			CellItem* item = reinterpret_cast<CellItem*>(list.item(row));
+			if (item->holder && item->holder.has<Cell>()) {
+				cell = item->holder;
+			} else if (gAtlasUtil.currentAtlas) {
+				// Names are only the fallback for items that lost their holder
+				auto& cells = gAtlasUtil.currentAtlas->cells;
+				auto it = cells.find(item->text().toStdString());
+				if (it != cells.end())
+					cell = it->second;
+			}
+		} return cell;
 	}
 
 	void PivotView::showEditor() {
@@ -462,26 +698,88 @@ namespace el
 			mGhostData.type = ElangAtlasGhostData::eType::INDEXED;
 		} 
 
-		QDialog dialog;
-		AtlasPalette palette(&dialog, true);
+		if (!mGhostData.material || !mGhostData.material->hasTexture())
+			return;
 
-		palette.updateAtlas(mGhostData.material->textures[0]->atlas);
-		palette.updateMaterial(mGhostData.material, gAtlasUtil.globalPalettePositon, gAtlasUtil.globalPaletteScale);
-		palette.sig_Clicked.connect([&](asset<Cell> cell) {
-			mGhostData.cell = cell;
-			dialog.close();
-		});
-		dialog.exec();
-		gAtlasUtil.globalPalettePositon = palette.camPosition();
-		gAtlasUtil.globalPaletteScale = palette.camScale();
+		auto& picker = ghostPicker(mGhostData.material);
+		picker.dialog->exec();
+		gAtlasUtil.globalPalettePositon = picker.palette->camPosition();
+		gAtlasUtil.globalPaletteScale = picker.palette->camScale();
 		update();
 	}
 
+	PivotView::GhostPicker& PivotView::ghostPicker(asset<Material> material) {
+		static const sizet cMaxPickers = 4;
+
+		auto it = mGhostPickers.find(material);
+		if (it == mGhostPickers.end()) {
+			if (mGhostPickers.size() >= cMaxPickers) {
+				auto oldest = mGhostPickers.begin();
+				for (auto jt = mGhostPickers.begin(); jt != mGhostPickers.end(); jt++)
+					if (jt->second.lastUse < oldest->second.lastUse)
+						oldest = jt;
+				delete oldest->second.dialog;
+				mGhostPickers.erase(oldest);
+			}
+
+			GhostPicker picker;
+			picker.dialog = new QDialog(this);
+			picker.palette = new AtlasPalette(picker.dialog, true);
+			picker.signature = 0;
+			auto dialog = picker.dialog;
+			picker.palette->sig_Clicked.connect([this, dialog](asset<Cell> cell) {
+				mGhostData.cell = cell;
+				dialog->close();
+			});
+			it = mGhostPickers.emplace(material, picker).first;
+		}
+
+		auto& picker = it->second;
+		picker.lastUse = ++mGhostPickerUses;
+
+		auto tex = material->textures[0];
+		asset<Atlas> atlas = tex->atlas;
+		uint64_t signature = 14695981039346656037ull;
+		auto mix = [&](uint64_t value) { signature = (signature ^ value) * 1099511628211ull; };
+		mix(tex->id());
+		mix(tex->width());
+		mix(tex->height());
+		mix(std::hash<Entity>()(atlas));
+		if (atlas && atlas.has<AssetLoaded>()) {
+			for (asset<CellHolder> holder : atlas.get<AtlasMeta>().cellorder) {
+				auto& cm = holder.get<CellMeta>();
+				mix(cm.x);
+				mix(cm.y);
+				mix(cm.w);
+				mix(cm.h);
+			}
+		}
+
+		if (picker.signature != signature) {
+			picker.palette->updateAtlas(atlas);
+			picker.palette->updateMaterial(material, gAtlasUtil.globalPalettePositon, gAtlasUtil.globalPaletteScale);
+			picker.signature = signature;
+		} else {
+			// Selections are shared by every palette, another one may have moved it since
+			picker.palette->refreshSelection();
+		} return picker;
+	}
+
 	void PivotView::setGhostPosition(bool front) {
 		mGhostData.order = front ? ElangAtlasGhostData::eOrder::FRONT : ElangAtlasGhostData::eOrder::BACK;
 		update();
 	}
 
+	void PivotView::setOnionDepth(int depth) {
+		mGhostData.onionDepth = (uint)max(depth, 0);
+		update();
+	}
+
+	void PivotView::setOnionFromClip(bool fromClip) {
+		mGhostData.onionFromClip = fromClip;
+		update();
+	}
+
 	void PivotView::onKeyPress(QKeyEvent* e) {
 		if (e->key() == Qt::Key::Key_Control || e->key() == Qt::Key::Key_Alt) {
 			onViewMouseMove();
@@ -1,6 +1,7 @@
 #pragma once
 #include "ghost_dialog.h"
 #include "../elqt/extension/view.h"
+#include "pixel_block.h"
 
 #include <tools/camera.h>
 #include <elements/basic.h>
@@ -8,10 +9,13 @@
 #include <elements/button.h>
 
 #include <tweeny/tween.h>
+#include <unordered_map>
 
 namespace el
 {
 	struct ShapeDebug2d;
+	struct CellHolder;
+	class QElangPaletteWidget;
 	struct PivotView : public QElangView
 	{
 		Q_OBJECT
@@ -53,6 +57,13 @@ namespace el
 		void ghostPalette();
 
 		void setGhostPosition(bool front);
+		void setOnionDepth(int depth);
+		void setOnionFromClip(bool fromClip);
+
+		// Shifts the current cell's pivot so its alpha lines up best with the ghost, within radius pixels
+		bool autoAlignToGhost(int radius = 32);
+		// Lines up every frame of the selected clip with the frame before it, returns the number of cells moved
+		sizet autoAlignClip(int radius = 32);
 
 		void release();
 		void loop();
@@ -73,6 +84,7 @@ namespace el
 		asset<Painter> mPainter;
 
 		Sprite mCellSprite, mGhostSprite;
+		vector<Sprite> mOnionSprites;
 		Position mCellPos;
 
 		eState mCreateState;
@@ -83,7 +95,28 @@ namespace el
 		ElangAtlasGhostData mGhostData;
 		ShapeDebug2d* mHighlighter;
 		vec2 mGrabPos, mGrabUV;
+		// Cell of every list row, resolved once through the item's holder; cleared whenever the list changes
+		vector<asset<Cell>> mRowCells;
+		// Palette pickers stay alive between ghostPalette calls, one per ghost material, and are only
+		// rebatched when the texture or the cell rects changed since they were last shown
+		struct GhostPicker
+		{
+			QDialog* dialog;
+			QElangPaletteWidget* palette;
+			uint64_t signature;
+			uint64_t lastUse;
+		};
+		std::unordered_map<Entity, GhostPicker> mGhostPickers;
+		uint64_t mGhostPickerUses;
+		GhostPicker& ghostPicker(asset<Material> material);
+
 		void connectList();
 		void paintGhostCell();
+		bool resolveGhost(asset<Cell>& cell, asset<Material>& material);
+		void paintOnionSkins();
+		// Points every sprite at mPainter after gEditorGL swapped it
+		void rebindPainter();
+		void collectOnionCells(vector<asset<Cell>>& prev, vector<asset<Cell>>& next);
+		asset<Cell> cellAtRow(int row);
 	};
 }
\ No newline at end of file
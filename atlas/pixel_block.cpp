@@ -0,0 +1,95 @@
+#include <elqtpch.h>
+#include "pixel_block.h"
+
+#include <tools/texture.h>
+
+namespace el
+{
+	bool PixelBlock::loadFromFile(const fio::path& path) {
+		QImage image;
+		if (!image.load(QString::fromUtf8(path.generic_u8string())))
+			return false;
+		return loadFromImage(image);
+	}
+
+	bool PixelBlock::loadFromImage(const QImage& source) {
+		if (source.isNull())
+			return false;
+
+		auto image = source.convertToFormat(QImage::Format_RGBA8888);
+		width = image.width();
+		height = image.height();
+		rgba.resize((sizet)width * height * 4);
+		for (int y = 0; y < height; y++)
+			memcpy(&rgba[(sizet)y * width * 4], image.constScanLine(y), (sizet)width * 4);
+		return true;
+	}
+
+	bool PixelBlock::loadFromTexture(asset<Texture> tex) {
+		if (!tex || !tex.has<AssetLoaded>())
+			return false;
+
+		width = (int)tex->width();
+		height = (int)tex->height();
+		rgba.resize((sizet)width * height * 4);
+
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, tex->id());
+		glPixelStorei(GL_PACK_ALIGNMENT, 1);
+		glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, rgba.data());
+		return true;
+	}
+
+	vector<PixelRect> findOpaqueRegions(const PixelBlock& pixels, uint alphaCut) {
+		vector<PixelRect> rects;
+		if (pixels.empty())
+			return rects;
+
+		auto w = pixels.width;
+		auto h = pixels.height;
+		vector<bool> visited((sizet)w * h, false);
+		vector<int> valids;
+
+		for (int y = 0; y < h; y++) {
+			for (int x = 0; x < w; x++) {
+				int start = x + y * w;
+				if (visited[start] || pixels.alpha(x, y) <= alphaCut)
+					continue;
+
+				PixelRect rect(x, y, x + 1, y + 1);
+				valids.clear();
+				valids.push_back(start);
+				visited[start] = true;
+
+				while (!valids.empty()) {
+					auto curr = valids.back();
+					valids.pop_back();
+
+					int cx = curr % w;
+					int cy = curr / w;
+					rect.l = min(rect.l, cx);
+					rect.t = min(rect.t, cy);
+					rect.r = max(rect.r, cx + 1);
+					rect.b = max(rect.b, cy + 1);
+
+					auto visit = [&](int nx, int ny) {
+						int next = nx + ny * w;
+						if (!visited[next] && pixels.alpha(nx, ny) > alphaCut) {
+							visited[next] = true;
+							valids.push_back(next);
+						}
+					};
+
+					if (cy > 0) visit(cx, cy - 1);
+					if (cy < h - 1) visit(cx, cy + 1);
+					if (cx > 0) visit(cx - 1, cy);
+					if (cx < w - 1) visit(cx + 1, cy);
+				}
+
+				rects.push_back(rect);
+			}
+		}
+
+		return rects;
+	}
+}
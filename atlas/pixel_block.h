@@ -0,0 +1,59 @@
+#pragma once
+#include <tools/asset.h>
+
+namespace el
+{
+	struct Texture;
+
+	// Rectangle in image pixel space, top row is 0. r and b are exclusive.
+	struct PixelRect
+	{
+		int l, t, r, b;
+
+		PixelRect() : l(0), t(0), r(0), b(0) {}
+		PixelRect(int l_, int t_, int r_, int b_) : l(l_), t(t_), r(r_), b(b_) {}
+
+		int width() const { return r - l; }
+		int height() const { return b - t; }
+		bool empty() const { return r <= l || b <= t; }
+		bool operator==(const PixelRect& rhs) const { return l == rhs.l && t == rhs.t && r == rhs.r && b == rhs.b; }
+		bool operator!=(const PixelRect& rhs) const { return !(*this == rhs); }
+
+		PixelRect clipped(const PixelRect& bounds) const {
+			return PixelRect(
+				clamp(l, bounds.l, bounds.r), clamp(t, bounds.t, bounds.b),
+				clamp(r, bounds.l, bounds.r), clamp(b, bounds.t, bounds.b)
+			);
+		}
+
+		// Editor boxes live in texture space where y goes down into negatives
+		Box toBox() const { return Box(l, -b, r, -t); }
+		static PixelRect fromBox(const Box& box) {
+			return PixelRect((int)round(box.l), (int)round(-box.t), (int)round(box.r), (int)round(-box.b));
+		}
+	};
+
+	// CPU copy of a texture in tightly packed RGBA8, top row first.
+	// Safe to read from worker threads once loaded.
+	struct PixelBlock
+	{
+		int width, height;
+		vector<unsigned char> rgba;
+
+		PixelBlock() : width(0), height(0) {}
+
+		bool loadFromFile(const fio::path& path);
+		bool loadFromImage(const QImage& image);
+		// Reads back the texture through GL, a context must be current
+		bool loadFromTexture(asset<Texture> tex);
+
+		bool empty() const { return rgba.empty(); }
+		const unsigned char* row(int y) const { return &rgba[(sizet)y * width * 4]; }
+		unsigned char alpha(int x, int y) const { return rgba[((sizet)y * width + x) * 4 + 3]; }
+		PixelRect bounds() const { return PixelRect(0, 0, width, height); }
+	};
+
+	// Bounding rects of every 4-connected region with alpha above alphaCut, in scan order.
+	// Same fill rule as the Auto Cell tool, applied over the whole image.
+	vector<PixelRect> findOpaqueRegions(const PixelBlock& pixels, uint alphaCut);
+}
@@ -0,0 +1,389 @@
+#include <elqtpch.h>
+#include "pixel_ops.h"
+
+#include <climits>
+
+#ifdef EL_PIXEL_SSE2
+# include <emmintrin.h>
+#endif
+
+namespace el
+{
+	namespace
+	{
+		const uint32_t cHashPrime = 0x9E3779B1u;
+
+		inline uint32_t rotl32(uint32_t x, int r) { return (x << r) | (x >> (32 - r)); }
+
+		inline uint32_t hashLane(uint32_t lane, uint32_t pixel) {
+			return rotl32((lane ^ pixel) * cHashPrime, 13);
+		}
+
+#ifdef EL_PIXEL_SSE2
+		// SSE2 has no 32-bit low multiply, emulate it with two widening multiplies
+		inline __m128i mullo32(__m128i a, __m128i b) {
+			__m128i even = _mm_mul_epu32(a, b);
+			__m128i odd = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+			return _mm_unpacklo_epi32(
+				_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+				_mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0))
+			);
+		}
+
+		// Bitmask of the four pixels at p whose alpha is above the cut
+		inline int opaqueMask4(const unsigned char* p, __m128i cut) {
+			const __m128i alphas = _mm_set1_epi32((int)0xFF000000);
+			__m128i above = _mm_and_si128(_mm_subs_epu8(_mm_loadu_si128((const __m128i*)p), cut), alphas);
+			int zero = _mm_movemask_epi8(_mm_cmpeq_epi32(above, _mm_setzero_si128()));
+			return ~zero & 0xFFFF;
+		}
+#endif
+
+		void fillPixel(uint32_t* dst, int count, uint32_t pixel) {
+			int i = 0;
+#ifdef EL_PIXEL_SSE2
+			const __m128i v = _mm_set1_epi32((int)pixel);
+			for (; i + 4 <= count; i += 4)
+				_mm_storeu_si128((__m128i*)(dst + i), v);
+#endif
+			for (; i < count; i++)
+				dst[i] = pixel;
+		}
+
+		// First pixel in [from, to) with alpha above the cut, or to
+		int firstOpaque(const unsigned char* row, int from, int to, uint alphaCut) {
+			int x = from;
+#ifdef EL_PIXEL_SSE2
+			const __m128i cut = _mm_set1_epi8((char)min(alphaCut, 255u));
+			for (; x + 4 <= to; x += 4) {
+				if (opaqueMask4(row + x * 4, cut))
+					break;
+			}
+#endif
+			for (; x < to; x++) {
+				if (row[x * 4 + 3] > alphaCut)
+					return x;
+			}
+			return to;
+		}
+
+		// Last pixel in [from, to) with alpha above the cut, or from - 1
+		int lastOpaque(const unsigned char* row, int from, int to, uint alphaCut) {
+			int x = to;
+#ifdef EL_PIXEL_SSE2
+			const __m128i cut = _mm_set1_epi8((char)min(alphaCut, 255u));
+			for (; x - 4 >= from; x -= 4) {
+				if (opaqueMask4(row + (x - 4) * 4, cut))
+					break;
+			}
+#endif
+			for (x--; x >= from; x--) {
+				if (row[x * 4 + 3] > alphaCut)
+					return x;
+			}
+			return from - 1;
+		}
+
+		// Sum of a[i] * b[i] over n bytes
+		uint64_t dotBytes(const unsigned char* a, const unsigned char* b, int n) {
+			int i = 0;
+			uint64_t sum = 0;
+#ifdef EL_PIXEL_SSE2
+			// Each step adds at most 4 * 255 * 255 to a 32-bit lane, so lanes are flushed into sum before 8192 steps
+			static const int cFlushSteps = 4096;
+			const __m128i zero = _mm_setzero_si128();
+			while (i + 16 <= n) {
+				__m128i acc = zero;
+				for (int step = 0; step < cFlushSteps && i + 16 <= n; step++, i += 16) {
+					__m128i va = _mm_loadu_si128((const __m128i*)(a + i));
+					__m128i vb = _mm_loadu_si128((const __m128i*)(b + i));
+					acc = _mm_add_epi32(acc, _mm_madd_epi16(_mm_unpacklo_epi8(va, zero), _mm_unpacklo_epi8(vb, zero)));
+					acc = _mm_add_epi32(acc, _mm_madd_epi16(_mm_unpackhi_epi8(va, zero), _mm_unpackhi_epi8(vb, zero)));
+				}
+				uint32_t lanes[4];
+				_mm_storeu_si128((__m128i*)lanes, acc);
+				sum += (uint64_t)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+			}
+#endif
+			for (; i < n; i++)
+				sum += (uint32_t)a[i] * b[i];
+			return sum;
+		}
+
+		AlphaPlane halveAlpha(const AlphaPlane& plane) {
+			AlphaPlane half;
+			half.width = max(1, (plane.width + 1) / 2);
+			half.height = max(1, (plane.height + 1) / 2);
+			half.alpha.resize((sizet)half.width * half.height);
+			for (int y = 0; y < half.height; y++) {
+				int y0 = min(y * 2, plane.height - 1), y1 = min(y * 2 + 1, plane.height - 1);
+				for (int x = 0; x < half.width; x++) {
+					int x0 = min(x * 2, plane.width - 1), x1 = min(x * 2 + 1, plane.width - 1);
+					uint sum = plane.row(y0)[x0] + plane.row(y0)[x1] + plane.row(y1)[x0] + plane.row(y1)[x1];
+					half.alpha[(sizet)y * half.width + x] = (unsigned char)((sum + 2) / 4);
+				}
+			}
+			return half;
+		}
+
+		// Correlation of fixed with moving placed at (x, y), only the overlap contributes
+		uint64_t correlate(const AlphaPlane& fixed, const AlphaPlane& moving, int x, int y) {
+			int l = max(0, x), r = min(fixed.width, x + moving.width);
+			int t = max(0, y), b = min(fixed.height, y + moving.height);
+			if (l >= r || t >= b)
+				return 0;
+
+			uint64_t sum = 0;
+			for (int row = t; row < b; row++)
+				sum += dotBytes(fixed.row(row) + l, moving.row(row - y) + (l - x), r - l);
+			return sum;
+		}
+
+		double energy(const AlphaPlane& plane) {
+			return (double)dotBytes(plane.alpha.data(), plane.alpha.data(), (int)plane.alpha.size());
+		}
+	}
+
+	uint64_t hashPixels(const PixelBlock& pixels, const PixelRect& rect) {
+		// Four lanes, one per pixel of every group of four, then the row tail in a fifth scalar lane
+		uint32_t lanes[4] = { 0x8F1BBCDCu, 0xCA62C1D6u, 0x5A827999u, 0x6ED9EBA1u };
+		uint32_t tail = (uint32_t)rect.width() * 0x85EBCA6Bu ^ (uint32_t)rect.height();
+
+		auto w = rect.width();
+		auto groups = w / 4;
+
+#ifdef EL_PIXEL_SSE2
+		__m128i acc = _mm_loadu_si128((const __m128i*)lanes);
+		const __m128i prime = _mm_set1_epi32((int)cHashPrime);
+#endif
+
+		for (int y = rect.t; y < rect.b; y++) {
+			auto row = (const uint32_t*)(pixels.row(y)) + rect.l;
+			int g = 0;
+#ifdef EL_PIXEL_SSE2
+			for (; g < groups; g++) {
+				__m128i v = _mm_loadu_si128((const __m128i*)(row + g * 4));
+				acc = mullo32(_mm_xor_si128(acc, v), prime);
+				acc = _mm_or_si128(_mm_slli_epi32(acc, 13), _mm_srli_epi32(acc, 19));
+			}
+#else
+			for (; g < groups; g++) {
+				for (int l = 0; l < 4; l++)
+					lanes[l] = hashLane(lanes[l], row[g * 4 + l]);
+			}
+#endif
+			for (int x = groups * 4; x < w; x++)
+				tail = hashLane(tail, row[x]);
+		}
+
+#ifdef EL_PIXEL_SSE2
+		_mm_storeu_si128((__m128i*)lanes, acc);
+#endif
+
+		uint64_t hash = 14695981039346656037ull;
+		for (auto lane : lanes)
+			hash = (hash ^ lane) * 1099511628211ull;
+		return (hash ^ tail) * 1099511628211ull;
+	}
+
+	bool equalPixels(const PixelBlock& pixels, const PixelRect& lhs, const PixelRect& rhs) {
+		if (lhs.width() != rhs.width() || lhs.height() != rhs.height())
+			return false;
+
+		auto bytes = (sizet)lhs.width() * 4;
+		for (int y = 0; y < lhs.height(); y++) {
+			if (memcmp(pixels.row(lhs.t + y) + lhs.l * 4, pixels.row(rhs.t + y) + rhs.l * 4, bytes) != 0)
+				return false;
+		}
+		return true;
+	}
+
+	PixelRect opaqueBounds(const PixelBlock& pixels, const PixelRect& rect, uint alphaCut) {
+		int top = rect.b, bottom = rect.t;
+		for (int y = rect.t; y < rect.b; y++) {
+			if (firstOpaque(pixels.row(y), rect.l, rect.r, alphaCut) < rect.r) {
+				top = y;
+				break;
+			}
+		}
+		if (top == rect.b)
+			return PixelRect(rect.l, rect.t, rect.l, rect.t);
+
+		for (int y = rect.b - 1; y >= top; y--) {
+			if (firstOpaque(pixels.row(y), rect.l, rect.r, alphaCut) < rect.r) {
+				bottom = y + 1;
+				break;
+			}
+		}
+
+		// Each row only needs scanning up to the best edge found so far
+		int left = rect.r, right = rect.l;
+		for (int y = top; y < bottom; y++) {
+			auto row = pixels.row(y);
+			left = min(left, firstOpaque(row, rect.l, left, alphaCut));
+			right = max(right, lastOpaque(row, right, rect.r, alphaCut) + 1);
+		}
+		return PixelRect(left, top, right, bottom);
+	}
+
+	bool alphaCentroid(const PixelBlock& pixels, const PixelRect& rect, uint alphaCut, float& x, float& y) {
+		uint64_t mass = 0;
+		double sumX = 0.0, sumY = 0.0;
+		for (int py = rect.t; py < rect.b; py++) {
+			auto row = pixels.row(py);
+			uint64_t rowMass = 0;
+			double rowX = 0.0;
+			for (int px = rect.l; px < rect.r; px++) {
+				auto a = row[px * 4 + 3];
+				if (a > alphaCut) {
+					rowMass += a;
+					rowX += (double)a * px;
+				}
+			}
+			mass += rowMass;
+			sumX += rowX;
+			sumY += (double)rowMass * py;
+		}
+
+		if (mass == 0)
+			return false;
+		x = (float)(sumX / mass) + 0.5f;
+		y = (float)(sumY / mass) + 0.5f;
+		return true;
+	}
+
+	AlphaPlane extractAlpha(const PixelBlock& pixels, const PixelRect& rect) {
+		AlphaPlane plane;
+		plane.width = max(0, rect.width());
+		plane.height = max(0, rect.height());
+		plane.alpha.resize((sizet)plane.width * plane.height);
+		for (int y = 0; y < plane.height; y++) {
+			auto src = pixels.row(rect.t + y) + rect.l * 4 + 3;
+			auto dst = &plane.alpha[(sizet)y * plane.width];
+			for (int x = 0; x < plane.width; x++)
+				dst[x] = src[x * 4];
+		}
+		return plane;
+	}
+
+	float alignAlpha(const AlphaPlane& fixed, const AlphaPlane& moving, int x, int y, int radius, int& dx, int& dy) {
+		dx = dy = 0;
+		if (fixed.alpha.empty() || moving.alpha.empty())
+			return 0.0f;
+
+		// Halve until the search window at the top level is small, but keep enough pixels to match shapes
+		vector<AlphaPlane> fixedLevels(1, fixed), movingLevels(1, moving);
+		while ((radius >> (fixedLevels.size() - 1)) > 4 &&
+			min(min(fixedLevels.back().width, fixedLevels.back().height), min(movingLevels.back().width, movingLevels.back().height)) >= 16) {
+			fixedLevels.push_back(halveAlpha(fixedLevels.back()));
+			movingLevels.push_back(halveAlpha(movingLevels.back()));
+		}
+
+		// Winner kept as an absolute position in the current level's pixels
+		int top = (int)fixedLevels.size() - 1;
+		int bestX = 0, bestY = 0;
+		for (int level = top; level >= 0; level--) {
+			auto& f = fixedLevels[level];
+			auto& m = movingLevels[level];
+			int scale = 1 << level;
+
+			// Full window at the top level, then refine the doubled winner by a pixel either way
+			int centerX = (level == top) ? (int)floor((float)x / scale) : bestX * 2;
+			int centerY = (level == top) ? (int)floor((float)y / scale) : bestY * 2;
+			int span = (level == top) ? (radius + scale - 1) / scale : 1;
+
+			uint64_t best = 0;
+			int winX = centerX, winY = centerY, winMove = INT_MAX;
+			for (int py = centerY - span; py <= centerY + span; py++) {
+				for (int px = centerX - span; px <= centerX + span; px++) {
+					int moveX = abs(px * scale - x), moveY = abs(py * scale - y);
+					if (moveX > radius + scale - 1 || moveY > radius + scale - 1)
+						continue;
+					// Ties keep the smaller move
+					auto score = correlate(f, m, px, py);
+					if (score > best || (score == best && moveX + moveY < winMove)) {
+						best = score;
+						winX = px;
+						winY = py;
+						winMove = moveX + moveY;
+					}
+				}
+			}
+			bestX = winX;
+			bestY = winY;
+		}
+
+		bestX = clamp(bestX - x, -radius, radius);
+		bestY = clamp(bestY - y, -radius, radius);
+		dx = bestX;
+		dy = bestY;
+		auto norm = sqrt(energy(fixed) * energy(moving));
+		return (norm > 0.0) ? (float)(correlate(fixed, moving, x + dx, y + dy) / norm) : 0.0f;
+	}
+
+	void extrudeRect(PixelBlock& pixels, const PixelRect& interior, int padding) {
+		if (padding <= 0 || interior.empty())
+			return;
+
+		auto stride = (sizet)pixels.width;
+		auto base = (uint32_t*)pixels.rgba.data();
+		auto w = interior.width();
+
+		for (int y = interior.t; y < interior.b; y++) {
+			auto row = base + y * stride;
+			fillPixel(row + interior.l - padding, padding, row[interior.l]);
+			fillPixel(row + interior.r, padding, row[interior.r - 1]);
+		}
+
+		// Full padded rows, so the corners take the corner pixel
+		auto bytes = (sizet)(w + padding * 2) * 4;
+		auto top = base + interior.t * stride + interior.l - padding;
+		auto bottom = base + (interior.b - 1) * stride + interior.l - padding;
+		for (int i = 1; i <= padding; i++) {
+			memcpy(top - i * stride, top, bytes);
+			memcpy(bottom + i * stride, bottom, bytes);
+		}
+	}
+
+	void downsampleRect(const PixelBlock& pixels, const PixelRect& rect, PixelBlock& dst, const PixelRect& to) {
+		auto w = rect.width();
+		auto h = rect.height();
+		auto dstWidth = to.width();
+		auto dstHeight = to.height();
+		if (w <= 0 || h <= 0 || dstWidth <= 0 || dstHeight <= 0)
+			return;
+
+		for (int dy = 0; dy < dstHeight; dy++) {
+			int sy0 = rect.t + dy * h / dstHeight;
+			int sy1 = max(sy0 + 1, rect.t + (dy + 1) * h / dstHeight);
+			auto out = &dst.rgba[((sizet)(to.t + dy) * dst.width + to.l) * 4];
+
+			for (int dx = 0; dx < dstWidth; dx++) {
+				int sx0 = rect.l + dx * w / dstWidth;
+				int sx1 = max(sx0 + 1, rect.l + (dx + 1) * w / dstWidth);
+
+				uint64_t r = 0, g = 0, b = 0, a = 0;
+				for (int sy = sy0; sy < sy1; sy++) {
+					auto p = pixels.row(sy) + sx0 * 4;
+					for (int sx = sx0; sx < sx1; sx++, p += 4) {
+						r += p[0] * p[3];
+						g += p[1] * p[3];
+						b += p[2] * p[3];
+						a += p[3];
+					}
+				}
+
+				auto count = (uint64_t)(sx1 - sx0) * (sy1 - sy0);
+				auto px = out + dx * 4;
+				if (a == 0) {
+					px[0] = px[1] = px[2] = px[3] = 0;
+				} else {
+					px[0] = (unsigned char)((r + a / 2) / a);
+					px[1] = (unsigned char)((g + a / 2) / a);
+					px[2] = (unsigned char)((b + a / 2) / a);
+					px[3] = (unsigned char)((a + count / 2) / count);
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include "pixel_block.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# define EL_PIXEL_SSE2
+#endif
+
+namespace el
+{
+	// Per-cell pixel work on CPU pixel data. Every function only reads the block, so cells can be processed in parallel.
+	// SSE2 paths produce exactly the same results as the scalar fallbacks.
+
+	// Hash of the RGBA bytes inside rect, including its size
+	uint64_t hashPixels(const PixelBlock& pixels, const PixelRect& rect);
+
+	// Byte-for-byte comparison of two equally sized blocks
+	bool equalPixels(const PixelBlock& pixels, const PixelRect& lhs, const PixelRect& rhs);
+
+	// Tightest box inside rect holding every pixel with alpha above alphaCut, empty when there is none
+	PixelRect opaqueBounds(const PixelBlock& pixels, const PixelRect& rect, uint alphaCut);
+
+	// Alpha-weighted mean of the pixel centres inside rect with alpha above alphaCut, false when there is none
+	bool alphaCentroid(const PixelBlock& pixels, const PixelRect& rect, uint alphaCut, float& x, float& y);
+
+	// 8-bit alpha channel of one cell, row-major
+	struct AlphaPlane
+	{
+		int width, height;
+		vector<unsigned char> alpha;
+
+		AlphaPlane() : width(0), height(0) {}
+		const unsigned char* row(int y) const { return &alpha[(sizet)y * width]; }
+	};
+
+	AlphaPlane extractAlpha(const PixelBlock& pixels, const PixelRect& rect);
+
+	// Finds the integer offset (dx, dy), y down, that best lines moving up with fixed when moving's top-left sits at
+	// (x, y) relative to fixed's top-left. Offsets within radius are searched coarse to fine over a 2x alpha pyramid,
+	// scoring the normalized cross-correlation of the zero-padded masks. Returns the score of the winner, 0 to 1
+	float alignAlpha(const AlphaPlane& fixed, const AlphaPlane& moving, int x, int y, int radius, int& dx, int& dy);
+
+	// Repeats the edge pixels of interior outward by padding pixels on every side, corners included.
+	// The padded area must lie inside the block and must not overlap another cell's padded area
+	void extrudeRect(PixelBlock& pixels, const PixelRect& interior, int padding);
+
+	// Box-filters rect into the to rect of dst, averaging in premultiplied alpha so transparent neighbours
+	// don't darken the edges. to must lie inside dst and be no larger than rect
+	void downsampleRect(const PixelBlock& pixels, const PixelRect& rect, PixelBlock& dst, const PixelRect& to);
+}
@@ -0,0 +1,77 @@
+#include <elqtpch.h>
+#include "playback_clock.h"
+
+namespace el
+{
+	// A stall longer than this (window drag, modal dialog) resyncs instead of fast-forwarding the clip
+	static const double cMaxCatchUpMs = 1000.0;
+
+	PlaybackClock::PlaybackClock() :
+		mPeriodMs(1000.0 / 30.0), mAccumulatorMs(0.0), mIntervalCount(0), mIntervalNext(0),
+		mRate(30.0f), mDropped(0), mStarted(false) {}
+
+	void PlaybackClock::setRate(float fps) {
+		mRate = max(fps, 1.0f);
+		mPeriodMs = 1000.0 / mRate;
+		reset();
+	}
+
+	void PlaybackClock::reset() {
+		resync();
+		mIntervalCount = 0;
+		mIntervalNext = 0;
+		mDropped = 0;
+	}
+
+	uint PlaybackClock::advance() {
+		auto now = Clock::now();
+		if (!mStarted) {
+			mStarted = true;
+			mLast = mLastShown = now;
+			return 0;
+		}
+
+		mAccumulatorMs += std::chrono::duration<double, std::milli>(now - mLast).count();
+		mLast = now;
+		if (mAccumulatorMs > cMaxCatchUpMs) {
+			mAccumulatorMs = 0.0;
+			mLastShown = now;
+			return 1;
+		}
+
+		uint due = (uint)(mAccumulatorMs / mPeriodMs);
+		if (due == 0)
+			return 0;
+		mAccumulatorMs -= due * mPeriodMs;
+		mDropped += due - 1;
+
+		mIntervals[mIntervalNext] = std::chrono::duration<double, std::milli>(now - mLastShown).count();
+		mIntervalNext = (mIntervalNext + 1) % cHistory;
+		mIntervalCount = min(mIntervalCount + 1, cHistory);
+		mLastShown = now;
+		return due;
+	}
+
+	float PlaybackClock::fps() const {
+		if (mIntervalCount == 0)
+			return 0.0f;
+
+		double total = 0.0;
+		for (int i = 0; i < mIntervalCount; i++)
+			total += mIntervals[i];
+		return (total > 0.0) ? (float)(1000.0 * mIntervalCount / total) : 0.0f;
+	}
+
+	float PlaybackClock::jitterMs() const {
+		if (mIntervalCount < 2)
+			return 0.0f;
+
+		double mean = 0.0, variance = 0.0;
+		for (int i = 0; i < mIntervalCount; i++)
+			mean += mIntervals[i];
+		mean /= mIntervalCount;
+		for (int i = 0; i < mIntervalCount; i++)
+			variance += (mIntervals[i] - mean) * (mIntervals[i] - mean);
+		return (float)sqrt(variance / mIntervalCount);
+	}
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <chrono>
+
+namespace el
+{
+	// Fixed-rate frame clock for clip previews, measured against a monotonic clock instead of counting timer ticks.
+	// Late ticks report every frame that fell due so playback keeps the real pace, the extras count as dropped.
+	struct PlaybackClock
+	{
+		PlaybackClock();
+
+		void setRate(float fps);
+		// Clears the stats and starts over from the next advance
+		void reset();
+		// Starts over from the next advance without clearing the stats, for pauses that shouldn't count as late
+		void resync() { mStarted = false; mAccumulatorMs = 0.0; }
+		// Frames that fell due since the last call
+		uint advance();
+
+		float rate() const { return mRate; }
+		// Measured over the last cHistory shown frames
+		float fps() const;
+		float jitterMs() const;
+		uint dropped() const { return mDropped; }
+
+	private:
+		using Clock = std::chrono::steady_clock;
+		static constexpr int cHistory = 64;
+
+		Clock::time_point mLast, mLastShown;
+		double mPeriodMs, mAccumulatorMs;
+		double mIntervals[cHistory];
+		int mIntervalCount, mIntervalNext;
+		float mRate;
+		uint mDropped;
+		bool mStarted;
+	};
+}
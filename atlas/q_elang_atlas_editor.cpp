@@ -5,6 +5,7 @@
 #include <atlas/pivot_widget.h>
 #include <atlas/clips_widget.h>
 #include <common/string_algorithm.h>
+#include <QInputDialog>
 
 namespace el
 {
@@ -52,6 +53,61 @@ namespace el
 		connect(ui.actionOpenTexture, &QAction::triggered, this, &QElangAtlasEditor::openTexture);
 		connect(ui.actionOpenAtlas, &QAction::triggered, this, &QElangAtlasEditor::openAtlas);
 		connect(ui.actionSaveAtlas, &QAction::triggered, this, &QElangAtlasEditor::saveAtlas);
+		ui.menuEdit->addAction("Remove Duplicate Cells", [&]() {
+			beginWaitProcess();
+			auto removed = mCellsWidget->dedupeCells();
+			if (removed > 0 && mClipsWidget)
+				mClipsWidget->refreshFrames();
+			endWaitProcess();
+			auto report = QString("Removed %1 duplicate cells").arg(removed);
+			cout << report.toStdString() << endl;
+			ui.statusbar->showMessage(report);
+		});
+		ui.menuEdit->addAction("Repack Atlas...", this, &QElangAtlasEditor::repackAtlas);
+		ui.menuEdit->addAction("Auto Pivots...", [&]() {
+			QStringList rules = { "Bottom center of opaque bounds", "Center of opaque bounds", "Centroid of alpha" };
+			bool ok = false;
+			auto rule = QInputDialog::getItem(this, "Auto Pivots", "Pivot rule", rules, 0, false, &ok);
+			if (!ok)
+				return;
+			auto cut = QInputDialog::getInt(this, "Auto Pivots", "Alpha cut", 0, 0, 254, 1, &ok);
+			if (!ok)
+				return;
+
+			beginWaitProcess();
+			auto changed = mCellsWidget->autoPivots((CellsWidget::PivotRule)rules.indexOf(rule), (uint)cut);
+			if (changed > 0 && mPivotView)
+				mPivotView->update();
+			endWaitProcess();
+			auto report = QString("Set pivots of %1 cells").arg(changed);
+			cout << report.toStdString() << endl;
+			ui.statusbar->showMessage(report);
+		});
+		ui.menuEdit->addAction("Auto Hitboxes...", [&]() {
+			bool ok = false;
+			auto cut = QInputDialog::getInt(this, "Auto Hitboxes", "Alpha cut", 0, 0, 254, 1, &ok);
+			if (!ok)
+				return;
+
+			beginWaitProcess();
+			auto changed = mCellsWidget->autoHitboxes((uint)cut);
+			if (changed > 0 && mPivotView)
+				mPivotView->update();
+			endWaitProcess();
+			auto report = QString("Set hitboxes of %1 cells").arg(changed);
+			cout << report.toStdString() << endl;
+			ui.statusbar->showMessage(report);
+		});
+
+		ui.menuEdit->addAction("Release Idle Modes After...", [&]() {
+			bool ok = false;
+			auto seconds = QInputDialog::getInt(this, "Idle Modes", "Seconds a hidden Pivot or Clips mode is kept (0 keeps it)",
+				mModeIdleMs / 1000, 0, 24 * 60 * 60, 30, &ok);
+			if (ok)
+				setModeIdleRelease(seconds);
+		});
+
+		ui.menuFile->addAction("Export Padded Atlas...", this, &QElangAtlasEditor::exportPaddedAtlas);
 
 		connect(ui.actionSaveAtlasAs, &QAction::triggered, [&]() {
 			auto atlas = gAtlasUtil.currentAtlas;
@@ -106,6 +162,7 @@ namespace el
 				}
 
 				if (newAtlas) {
+					EL_TRACE_SCOPE("newAtlas");
 					beginWaitProcess();
 					data.filePath = path;
 					atlas.get<GUIAsset>().filePath = path.filename();
@@ -137,6 +194,7 @@ namespace el
 		fio::path path =
 			QFileDialog::getOpenFileName(this, "Open Texture", gAtlasUtil.lastSearchHistory.generic_string().c_str(), "PNG (*.png)").toStdString();
 
+		EL_TRACE_SCOPE("openTexture");
 		beginWaitProcess();
 		if (gAtlasUtil.openTexture(gAtlasUtil.currentMaterial, path))
 			mCellsWidget->updateMaterial(gAtlasUtil.currentMaterial);
@@ -153,6 +211,7 @@ namespace el
 		auto& data = atlas.get<AssetData>();
 		if (!path.empty() && data.inode != el_file::identifier(path)) {
 			if (askSaveMessage() != QMessageBox::Cancel) {
+				EL_TRACE_SCOPE("openAtlas");
 				gAtlasUtil.recordLastDirectoryHistory(path);
 				beginWaitProcess();
 				auto& meta = atlas.get<AtlasMeta>();
@@ -163,7 +222,10 @@ namespace el
 					atlas.add<AssetLoaded>();
 				}
 
-				atlas->importFile(path, meta);
+				{
+					EL_TRACE_SCOPE("importAtlasFile");
+					atlas->importFile(path, meta);
+				}
 				atlas.get<GUIAsset>().filePath = path.filename();
 				if (atlas.has<AssetModified>())
 					atlas.remove<AssetModified>();
@@ -171,7 +233,8 @@ namespace el
 				data = { el_file::identifier(path), path, fio::last_write_time(path) };
 
 				mCellsWidget->updateAtlas(atlas);
-				mClipsWidget->updateOnAtlasLoad();
+				if (mClipsWidget)
+					mClipsWidget->updateOnAtlasLoad();
 
 				updateEditorTitle(atlas);
 				endWaitProcess();
@@ -184,6 +247,7 @@ namespace el
 	void QElangAtlasEditor::saveAtlas() {
 		auto atlas = gAtlasUtil.currentAtlas;
 		if (atlas.has<AssetModified>()) {
+			EL_TRACE_SCOPE("saveAtlas");
 			beginWaitProcess();
 			auto& data = atlas.get<AssetData>();
 			atlas->exportFile(data.filePath, atlas.get<AtlasMeta>());
@@ -195,9 +259,128 @@ namespace el
 		}
 	}
 
+	void QElangAtlasEditor::repackAtlas() {
+		auto atlas = gAtlasUtil.currentAtlas;
+		auto mat = gAtlasUtil.currentMaterial;
+		if (!(mat && mat->hasTexture() && atlas.has<AssetLoaded>() && atlas.get<AtlasMeta>().cellorder.size() > 0)) {
+			QMessageBox::warning(this, "Nothing to repack.", "Please open a texture and an atlas with cells<br>before repacking.");
+			return;
+		}
+
+		QStringList sizes = { "Smallest power of two", "512 x 512", "1024 x 1024", "2048 x 2048", "4096 x 4096", "Custom..." };
+		bool ok = false;
+		auto choice = QInputDialog::getItem(this, "Repack Atlas", "Texture size", sizes, 0, false, &ok);
+		if (!ok)
+			return;
+
+		AtlasPackOptions options;
+		auto index = sizes.indexOf(choice);
+		if (index == sizes.size() - 1) {
+			options.width = QInputDialog::getInt(this, "Repack Atlas", "Width", 1024, 1, 16384, 1, &ok);
+			if (!ok) return;
+			options.height = QInputDialog::getInt(this, "Repack Atlas", "Height", 1024, 1, 16384, 1, &ok);
+			if (!ok) return;
+		} else if (index > 0) {
+			options.width = options.height = 256 << index;
+		}
+
+		options.spacing = QInputDialog::getInt(this, "Repack Atlas", "Spacing between cells", 1, 0, 64, 1, &ok);
+		if (!ok)
+			return;
+
+		fio::path path =
+			QFileDialog::getSaveFileName(this, "Save Packed Texture", gAtlasUtil.lastSearchHistory.generic_string().c_str(), "PNG (*.png)").toStdString();
+		if (path.empty())
+			return;
+		gAtlasUtil.recordLastDirectoryHistory(path);
+
+		// The repacked atlas is saved beside the new texture, ask before replacing another atlas there
+		auto atlasPath = path;
+		atlasPath.replace_extension(".atls");
+		if (fio::exists(atlasPath) && QMessageBox::question(this, "Confirm Atlas Overwrite",
+			tr("%1 already exists and will be replaced by the repacked atlas.<br>Are you sure you want to do this?")
+				.arg(QString::fromUtf8(atlasPath.filename().generic_u8string())),
+			QMessageBox::Yes | QMessageBox::No,
+			QMessageBox::No) != QMessageBox::Yes)
+			return;
+
+		EL_TRACE_SCOPE("repackAtlas");
+		beginWaitProcess();
+		PixelBlock packed;
+		AtlasPackResult result;
+		float before = 0.0f, after = 0.0f;
+		if (mCellsWidget->repackCells(options, packed, result, before, after)) {
+			QImage image(packed.rgba.data(), packed.width, packed.height, packed.width * 4, QImage::Format_RGBA8888);
+			if (!image.save(QString::fromUtf8(path.generic_u8string()), "PNG")) {
+				endWaitProcess();
+				QMessageBox::warning(this, "Repack failed.", "Could not write the packed texture. The atlas was left unchanged.");
+				return;
+			}
+			mCellsWidget->applyRepack(result);
+
+			// The repacked atlas becomes the current atlas file
+			auto& data = atlas.get<AssetData>();
+			data.filePath = atlasPath;
+			atlas->exportFile(data.filePath, atlas.get<AtlasMeta>());
+			data.lastWriteTime = fio::last_write_time(data.filePath);
+			data.inode = el_file::identifier(data.filePath);
+			atlas.get<GUIAsset>().filePath = data.filePath.filename();
+			if (atlas.has<AssetModified>())
+				atlas.remove<AssetModified>();
+
+			if (!gAtlasUtil.openTexture(mat, path))
+				refresh();
+			mCellsWidget->updateMaterial(mat);
+			mCellsWidget->updateAtlas(atlas);
+			updateEditorTitle(atlas);
+			backupAtlas();
+
+			auto report = QString("Repacked %1 cells into %2 x %3, occupancy %4% -> %5%")
+				.arg(atlas.get<AtlasMeta>().cellorder.size()).arg(packed.width).arg(packed.height)
+				.arg(before * 100.0f, 0, 'f', 1).arg(after * 100.0f, 0, 'f', 1);
+			cout << report.toStdString() << endl;
+			ui.statusbar->showMessage(report);
+			endWaitProcess();
+		} else {
+			endWaitProcess();
+			QMessageBox::warning(this, "Repack failed.", "The cells do not fit into the chosen texture size.");
+		}
+	}
+
+	void QElangAtlasEditor::exportPaddedAtlas() {
+		auto atlas = gAtlasUtil.currentAtlas;
+		auto mat = gAtlasUtil.currentMaterial;
+		if (!(mat && mat->hasTexture() && atlas.has<AssetLoaded>() && atlas.get<AtlasMeta>().cellorder.size() > 0)) {
+			QMessageBox::warning(this, "Nothing to export.", "Please open a texture and an atlas with cells<br>before exporting.");
+			return;
+		}
+
+		bool ok = false;
+		int padding = QInputDialog::getInt(this, "Export Padded Atlas", "Extruded pixels around each cell", 2, 1, 32, 1, &ok);
+		if (!ok)
+			return;
+
+		fio::path path =
+			QFileDialog::getSaveFileName(this, "Export Padded Texture", gAtlasUtil.lastSearchHistory.generic_string().c_str(), "PNG (*.png)").toStdString();
+		if (path.empty())
+			return;
+		gAtlasUtil.recordLastDirectoryHistory(path);
+
+		beginWaitProcess();
+		bool exported = mCellsWidget->exportPadded(path, padding);
+		endWaitProcess();
+
+		if (exported) {
+			ui.statusbar->showMessage(QString("Exported padded atlas to ") + QString::fromUtf8(path.generic_u8string()));
+		} else {
+			QMessageBox::warning(this, "Export failed.", "The padded texture could not be packed or written.");
+		}
+	}
+
 #define MAX_BACKUP 20
 
 	void QElangAtlasEditor::backupAtlas() {
+		EL_TRACE_SCOPE("backupAtlas");
 		string prefix = "backup_";
 		auto psize = prefix.size();
 		
@@ -249,6 +432,7 @@ namespace el
 				data.inode = el_file::identifier(data.filePath);
 				auto lwt = fio::last_write_time(data.filePath);
 				if (lwt > data.lastWriteTime) {
+					EL_TRACE_SCOPE("reloadTexture");
 					auto& meta = tex.get<TextureMeta>();
 					tex->unload(meta);
 					tex->importFile(data.filePath, meta);
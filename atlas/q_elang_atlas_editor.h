@@ -23,6 +23,8 @@ namespace el
 		void openAtlas();
 		void saveAtlas();
 		void backupAtlas();
+		void repackAtlas();
+		void exportPaddedAtlas();
 		void refresh();
 
 		void debugTexture();
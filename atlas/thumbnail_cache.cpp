@@ -0,0 +1,340 @@
+#include <elqtpch.h>
+#include "thumbnail_cache.h"
+
+#include <tools/cell.h>
+#include <tools/atlas.h>
+#include <tools/texture.h>
+#include <tools/material.h>
+#include <unordered_set>
+#include <algorithm>
+#include <sstream>
+#include <iomanip>
+#include "util.h"
+#include "pixel_ops.h"
+#include "parallel.h"
+#include "atlas_packer.h"
+
+namespace el
+{
+	ThumbnailCache::ThumbnailCache() : mSheetTexture(NullEntity), mSheetWidth(0), mSheetHeight(0), mSheetId(0),
+		mPageWidth(0), mPageHeight(0), mTileSize(cTileSize), mStale(true) {}
+
+	void ThumbnailCache::init() {
+		if (!mMaterial) {
+			if (!gAtlasUtil.thumbnailMaterial)
+				gAtlasUtil.makeEmptyMaterial("__editor_thumbnail_material_", gAtlasUtil.thumbnailMaterial, gAtlasUtil.thumbnailAtlas);
+			mMaterial = gAtlasUtil.thumbnailMaterial;
+			mAtlas = gAtlasUtil.thumbnailAtlas;
+
+			// Thumbnail cells left behind by a released cache are taken over instead of piling up in the page atlas
+			for (asset<Cell> thumb : mAtlas.get<AtlasMeta>().cellorder)
+				mFreeThumbs.push_back(thumb);
+		}
+	}
+
+	void ThumbnailCache::release() {
+		if (mMaterial) {
+			auto tex = mMaterial->textures[0];
+			if (tex.has<AssetLoaded>()) {
+				tex->unload(tex.get<TextureMeta>());
+				tex.remove<AssetLoaded>();
+			}
+		}
+
+		mSheetTexture = NullEntity;
+		mSheetWidth = mSheetHeight = 0;
+		mSheetId = 0;
+		mEntries.clear();
+		mFreeThumbs.clear();
+		mMaterial = asset<Material>();
+		mAtlas = asset<Atlas>();
+		mPageWidth = mPageHeight = 0;
+		mTileSize = cTileSize;
+		mStale = true;
+	}
+
+	asset<Cell> ThumbnailCache::thumbnail(asset<Cell> cell) {
+		auto it = mEntries.find(cell);
+		if (it != mEntries.end())
+			return it->second.thumb;
+		return asset<Cell>();
+	}
+
+	bool ThumbnailCache::sync(asset<Material> source) {
+		if (!mMaterial || !source || !source->hasTexture())
+			return false;
+
+		auto tex = source->textures[0];
+		asset<Atlas> atlas = tex->atlas;
+		if (!tex.has<AssetLoaded>() || !atlas || !atlas.has<AssetLoaded>())
+			return false;
+
+		auto& meta = atlas.get<AtlasMeta>();
+		auto bounds = PixelRect(0, 0, (int)tex->width(), (int)tex->height());
+		vector<Entity> order;
+		vector<PixelRect> rects;
+		order.reserve(meta.cellorder.size());
+		rects.reserve(meta.cellorder.size());
+		for (asset<CellHolder> holder : meta.cellorder) {
+			auto& cm = holder.get<CellMeta>();
+			order.push_back(holder);
+			rects.push_back(PixelRect((int)cm.x, (int)cm.y, (int)(cm.x + cm.w), (int)(cm.y + cm.h)).clipped(bounds));
+		}
+
+		if (mStale || mSheetWidth != bounds.r || mSheetHeight != bounds.b || sheetChanged(tex)) {
+			rebuildPage(tex, order, rects);
+			return true;
+		}
+
+		// Cells whose new thumbnail still fits their slot are re-tiled in place, anything else repacks the page.
+		// Cells left without a slot are known entries too, so they don't count as new on every sync
+		bool changed = false, repack = false;
+		vector<Entity> dirty;
+		std::unordered_set<Entity> seen;
+		for (sizet i = 0; i < order.size() && !repack; i++) {
+			seen.insert(order[i]);
+			auto it = mEntries.find(order[i]);
+			if (it == mEntries.end()) {
+				repack = true;
+			} else if (it->second.source != rects[i]) {
+				int w, h;
+				thumbSize(rects[i], w, h);
+				auto& slot = it->second.slot;
+				if (slot.empty() || w > slot.width() || h > slot.height()) {
+					repack = true;
+				} else {
+					it->second.source = rects[i];
+					dirty.push_back(order[i]);
+				}
+			}
+		}
+
+		if (repack) {
+			rebuildPage(tex, order, rects);
+			return true;
+		}
+
+		// Slots of removed cells simply stay unused until the next repack
+		for (auto it = mEntries.begin(); it != mEntries.end();) {
+			if (seen.count(it->first) == 0) {
+				if (it->second.thumb)
+					mFreeThumbs.push_back(it->second.thumb);
+				it = mEntries.erase(it);
+				changed = true;
+			} else it++;
+		}
+
+		if (dirty.size() > 0) {
+			PixelBlock sheet;
+			if (!sheet.loadFromTexture(tex))
+				return changed;
+
+			vector<Entry*> entries;
+			for (auto cell : dirty)
+				entries.push_back(&mEntries[cell]);
+			uploadTiles(sheet, entries);
+			for (sizet i = 0; i < dirty.size(); i++)
+				moldThumb(*entries[i], dirty[i]);
+			changed = true;
+		} return changed;
+	}
+
+	bool ThumbnailCache::sheetChanged(asset<Texture> tex) const {
+		if ((Entity)tex != mSheetTexture || tex->id() != mSheetId)
+			return true;
+		return tex.has<AssetData>() && tex.get<AssetData>().lastWriteTime != mSheetWriteTime;
+	}
+
+	void ThumbnailCache::rebuildPage(asset<Texture> tex, const vector<Entity>& order, const vector<PixelRect>& rects) {
+		EL_TRACE_SCOPE("rebuildThumbnailPage");
+		PixelBlock sheet;
+		if (!sheet.loadFromTexture(tex))
+			return;
+
+		mSheetTexture = tex;
+		mSheetWidth = sheet.width;
+		mSheetHeight = sheet.height;
+		mSheetId = tex->id();
+		if (tex.has<AssetData>())
+			mSheetWriteTime = tex.get<AssetData>().lastWriteTime;
+		mStale = false;
+
+		for (auto& pair : mEntries)
+			if (pair.second.thumb)
+				mFreeThumbs.push_back(pair.second.thumb);
+		mEntries.clear();
+
+		// Thumbnails are packed at their own size. Sheets of many cells shrink every thumbnail until the page fits,
+		// and past the smallest size only as many cells as fit get one
+		AtlasPackOptions options;
+		options.maxSize = cMaxPageSize;
+		AtlasPackResult result;
+		vector<PixelRect> sizes;
+		sizet count = order.size();
+		mTileSize = cTileSize;
+		while (count > 0) {
+			sizes.assign(count, PixelRect());
+			for (sizet i = 0; i < count; i++) {
+				int w, h;
+				thumbSize(rects[i], w, h);
+				sizes[i] = PixelRect(0, 0, w, h);
+			}
+			result = packRects(sizes, options);
+			if (result.success)
+				break;
+			if (mTileSize > cMinTileSize)
+				mTileSize /= 2;
+			else count = count * 3 / 4;
+		}
+		if (count < order.size())
+			cout << "Thumbnail page full, " << order.size() - count << " cells get no thumbnail" << endl;
+
+		mPageWidth = result.success ? result.width : 1;
+		mPageHeight = result.success ? result.height : 1;
+		auto& meta = mAtlas.get<AtlasMeta>();
+		meta.width = mPageWidth;
+		meta.height = mPageHeight;
+
+		for (sizet i = 0; i < order.size(); i++) {
+			Entry entry;
+			entry.source = rects[i];
+			if (i < count && !sizes[i].empty()) {
+				entry.slot = result.rects[i];
+				entry.thumb = makeThumb();
+			}
+			mEntries.emplace(order[i], entry);
+		}
+
+		// Same sheet and same rects always lay out the same page, so the hash of both names it
+		uint64_t key = hashPixels(sheet, sheet.bounds());
+		for (auto& rect : rects)
+			key = (key ^ ((uint64_t)rect.l << 48 ^ (uint64_t)rect.t << 32 ^ (uint64_t)rect.r << 16 ^ (uint64_t)rect.b)) * 1099511628211ull;
+
+		std::stringstream name;
+		name << std::hex << std::setw(16) << std::setfill('0') << key << "_" << std::dec << mTileSize << "_" << count << ".png";
+		auto directory = persistDirectory.empty() ? fio::temp_directory_path() : persistDirectory;
+		auto path = directory / name.str();
+
+		if (persistDirectory.empty() || !fio::exists(path)) {
+			PixelBlock page;
+			page.width = mPageWidth;
+			page.height = mPageHeight;
+			page.rgba.assign((sizet)mPageWidth * mPageHeight * 4, 0);
+
+			parallelFor(count, [&](sizet i) {
+				EL_TRACE_SCOPE("downsampleTile");
+				auto& entry = mEntries.at(order[i]);
+				if (!entry.slot.empty())
+					downsampleRect(sheet, entry.source, page, entry.slot);
+			});
+
+			fio::create_directories(directory);
+			QImage image(page.rgba.data(), page.width, page.height, QImage::Format_RGBA8888);
+			if (!image.save(QString::fromUtf8(path.generic_u8string()), "PNG"))
+				cout << "Failed to write thumbnail page " << path.generic_u8string() << endl;
+			else if (!persistDirectory.empty())
+				prunePersisted();
+		} else {
+			// Write time doubles as last use, so pages still being reopened survive pruning
+			std::error_code ec;
+			fio::last_write_time(path, fio::file_time_type::clock::now(), ec);
+		}
+
+		auto page = mMaterial->textures[0];
+		auto& texmeta = page.get<TextureMeta>();
+		if (page.has<AssetLoaded>())
+			page->unload(texmeta);
+		else page.add<AssetLoaded>();
+		page->importFile(path, texmeta);
+		if (persistDirectory.empty())
+			fio::remove(path);
+
+		for (sizet i = 0; i < order.size(); i++) {
+			auto& entry = mEntries[order[i]];
+			if (entry.thumb)
+				moldThumb(entry, order[i]);
+		}
+	}
+
+	void ThumbnailCache::prunePersisted() {
+		std::error_code ec;
+		vector<std::pair<fio::file_time_type, fio::path>> pages;
+		for (auto& entry : fio::directory_iterator(persistDirectory, ec)) {
+			if (entry.is_regular_file(ec) && entry.path().extension() == ".png")
+				pages.emplace_back(entry.last_write_time(ec), entry.path());
+		}
+		if (pages.size() <= cMaxPersistedPages)
+			return;
+
+		std::sort(pages.begin(), pages.end(), [](auto& a, auto& b) { return a.first > b.first; });
+		for (sizet i = cMaxPersistedPages; i < pages.size(); i++)
+			fio::remove(pages[i].second, ec);
+	}
+
+	void ThumbnailCache::uploadTiles(const PixelBlock& sheet, const vector<Entry*>& dirty) {
+		EL_TRACE_SCOPE("uploadThumbnailTiles");
+		// Whole slots are uploaded so leftovers of a previous, larger thumbnail get cleared too
+		vector<PixelBlock> tiles(dirty.size());
+		parallelFor(dirty.size(), [&](sizet i) {
+			auto& slot = dirty[i]->slot;
+			auto& tile = tiles[i];
+			tile.width = slot.width();
+			tile.height = slot.height();
+			tile.rgba.assign((sizet)tile.width * tile.height * 4, 0);
+
+			int w, h;
+			thumbSize(dirty[i]->source, w, h);
+			downsampleRect(sheet, dirty[i]->source, tile, PixelRect(0, 0, w, h));
+		});
+
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, mMaterial->textures[0]->id());
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		for (sizet i = 0; i < dirty.size(); i++) {
+			auto& slot = dirty[i]->slot;
+			glTexSubImage2D(GL_TEXTURE_2D, 0, slot.l, slot.t, slot.width(), slot.height(), GL_RGBA, GL_UNSIGNED_BYTE, tiles[i].rgba.data());
+		}
+	}
+
+	void ThumbnailCache::moldThumb(Entry& entry, Entity source) {
+		int w, h;
+		thumbSize(entry.source, w, h);
+		auto scale = (entry.source.width() > 0) ? (float)w / entry.source.width() : 1.0f;
+
+		// Pivot is scaled along with the pixels so the thumbnail keeps the cell's placement
+		auto& src = asset<CellHolder>(source).get<CellMeta>();
+		auto& cm = entry.thumb.get<CellMeta>();
+		cm.x = entry.slot.l;
+		cm.y = entry.slot.t;
+		cm.w = w;
+		cm.h = h;
+		cm.oX = (int)round(src.oX * scale);
+		cm.oY = (int)round(src.oY * scale);
+		entry.thumb->mold(cm, mPageWidth, mPageHeight);
+	}
+
+	asset<Cell> ThumbnailCache::makeThumb() {
+		if (mFreeThumbs.size() > 0) {
+			auto thumb = mFreeThumbs.back();
+			mFreeThumbs.pop_back();
+			return thumb;
+		}
+
+		auto& meta = mAtlas.get<AtlasMeta>();
+		auto cell = gProject.make<SubAssetData>(meta.cellorder.size(), string(), mAtlas).add<CellMeta>();
+		mAtlas->addCell(cell, meta);
+		return cell;
+	}
+
+	void ThumbnailCache::thumbSize(const PixelRect& source, int& w, int& h) const {
+		// Cells that already fit a tile are copied 1:1
+		auto longest = max(source.width(), source.height());
+		if (longest <= mTileSize) {
+			w = source.width();
+			h = source.height();
+		} else {
+			w = max(1, source.width() * mTileSize / longest);
+			h = max(1, source.height() * mTileSize / longest);
+		}
+	}
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include "pixel_block.h"
+
+#include <unordered_map>
+
+namespace el
+{
+	struct Atlas;
+	struct Material;
+	struct Cell;
+	struct Texture;
+
+	// Downsampled copy of every cell of the current atlas, packed at their downsampled sizes on a single texture page.
+	// Reel frames draw from it instead of sampling the full resolution sheet.
+	struct ThumbnailCache
+	{
+		// Longest side of a thumbnail, halved down to cMinTileSize while the cells don't fit a cMaxPageSize page
+		static constexpr int cTileSize = 96;
+		static constexpr int cMinTileSize = 8;
+		static constexpr int cMaxPageSize = 4096;
+
+		// Pages are also written to this directory keyed by sheet hash, so reopening an atlas skips the downsampling.
+		// Only the cMaxPersistedPages most recently used pages are kept there
+		fio::path persistDirectory;
+		static constexpr sizet cMaxPersistedPages = 32;
+
+		ThumbnailCache();
+
+		// Creates the page material, a GL context must be current
+		void init();
+		// Unloads the page, the next init and sync start over. A GL context must be current
+		void release();
+		// Re-tiles cells whose rect changed since the last sync, the whole page when cells were added, a thumbnail
+		// outgrew its slot or the sheet was reloaded: another texture, a new GL texture id or a newer file write time.
+		// The sheet is read back only for that and not kept. Returns whether any thumbnail moved or changed.
+		// A GL context must be current
+		bool sync(asset<Material> source);
+		// Forces the next sync to read the sheet back and rebuild every tile
+		void invalidate() { mStale = true; }
+
+		asset<Material> material() { return mMaterial; }
+		// Thumbnail cell standing in for cell, null when the cell isn't part of the synced atlas or didn't fit the page
+		asset<Cell> thumbnail(asset<Cell> cell);
+
+	private:
+		struct Entry
+		{
+			PixelRect source;
+			// Space reserved on the page, empty for cells left without a thumbnail
+			PixelRect slot;
+			asset<Cell> thumb;
+		};
+
+		void rebuildPage(asset<Texture> tex, const vector<Entity>& order, const vector<PixelRect>& rects);
+		void uploadTiles(const PixelBlock& sheet, const vector<Entry*>& dirty);
+		void moldThumb(Entry& entry, Entity source);
+		asset<Cell> makeThumb();
+		void thumbSize(const PixelRect& source, int& w, int& h) const;
+		bool sheetChanged(asset<Texture> tex) const;
+		void prunePersisted();
+
+		asset<Material> mMaterial;
+		asset<Atlas> mAtlas;
+		// Texture the page was built from, and its size, GL id and file write time at that point
+		Entity mSheetTexture;
+		int mSheetWidth, mSheetHeight;
+		uint mSheetId;
+		fio::file_time_type mSheetWriteTime;
+		std::unordered_map<Entity, Entry> mEntries;
+		vector<asset<Cell>> mFreeThumbs;
+		int mPageWidth, mPageHeight, mTileSize;
+		bool mStale;
+	};
+}
@@ -1,6 +1,7 @@
 #pragma once
 #include "../elqt/extension/list.h"
 #include "../elqt/widget/palette.h"
+#include "../elqt/extension/trace.h"
 #include <tools/atlas.h>
 #include <tools/texture.h>
 #include <tools/material.h>
@@ -25,6 +26,9 @@ namespace el
 	{
 		asset<Material> currentMaterial;
 		asset<Atlas> currentAtlas;
+		// Internal materials of the pivot ghost and the reel thumbnails, made once and kept when their mode is released
+		asset<Material> ghostMaterial, thumbnailMaterial;
+		asset<Atlas> ghostAtlas, thumbnailAtlas;
 		QListExtension* cellList, * clipList;
 		fio::path lastSearchHistory, backupDirectory;
 		vec2 globalPalettePositon;
@@ -70,7 +74,10 @@ namespace el
 					tex.add<AssetLoaded>();
 				}
 
-				tex->importFile(path, meta);
+				{
+					EL_TRACE_SCOPE("importTextureFile");
+					tex->importFile(path, meta);
+				}
 				tex.get<GUIAsset>().filePath = path.filename();
 				data = { el_file::identifier(path), path, fio::last_write_time(path) };
 				return true;
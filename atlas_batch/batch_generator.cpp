@@ -0,0 +1,164 @@
+#include <elqtpch.h>
+#include "batch_generator.h"
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <tools/atlas.h>
+#include <common/string_algorithm.h>
+#include <atlas/atlas_gen.h>
+#include <atlas/parallel.h>
+
+namespace el
+{
+	using BatchClock = std::chrono::steady_clock;
+
+	static double elapsedMs(BatchClock::time_point since) {
+		return std::chrono::duration<double, std::milli>(BatchClock::now() - since).count();
+	}
+
+	// FNV-1a, enough to notice a changed sprite sheet
+	static uint64_t hashBytes(const char* data, sizet size, uint64_t hash = 14695981039346656037ull) {
+		for (sizet i = 0; i < size; i++) {
+			hash ^= (unsigned char)data[i];
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
+	BatchAtlasGenerator::BatchAtlasGenerator(const BatchAtlasOptions& options) : mOptions(options) {}
+
+	fio::path BatchAtlasGenerator::cachePath() {
+		return (mOptions.output.empty() ? mOptions.input : mOptions.output) / ".atls_batch_cache";
+	}
+
+	void BatchAtlasGenerator::collect() {
+		for (auto& e : fio::recursive_directory_iterator(mOptions.input)) {
+			if (e.is_regular_file() && e.path().extension() == ".png") {
+				Job job;
+				job.source = e.path();
+				auto rel = fio::relative(e.path(), mOptions.input);
+				job.key = rel.generic_u8string();
+				job.target = (mOptions.output.empty() ? mOptions.input : mOptions.output) / rel;
+				job.target.replace_extension(".atls");
+				mJobs.emplace_back(std::move(job));
+			}
+		}
+	}
+
+	void BatchAtlasGenerator::loadCache() {
+		string in;
+		if (el_file::load(cachePath(), in) == 0) {
+			el_string::iterate(in, '\n', [&](strview div, sizet index) {
+				el_string::tokenize(div, '=', [&](strview head, strview tail) {
+					mCache[string(head)] = std::stoull(string(tail));
+				}); return false;
+			});
+		}
+	}
+
+	void BatchAtlasGenerator::saveCache() {
+		string out;
+		for (auto& job : mJobs) {
+			if (!job.failed) {
+				out.append(job.key);
+				out += '=';
+				out.append(std::to_string(job.hash));
+				out += '\n';
+			}
+		}
+		el_file::save(cachePath(), out);
+	}
+
+	void BatchAtlasGenerator::scan(Job& job) {
+		auto begin = BatchClock::now();
+
+		std::ifstream file(job.source, std::ios::binary);
+		string bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+		if (bytes.empty()) {
+			job.failed = true;
+			return;
+		}
+
+		// Generation settings take part in the hash so changing them regenerates everything
+		uint32_t settings[3] = { mOptions.alphaCut, mOptions.sortorder, mOptions.margin };
+		job.hash = hashBytes(bytes.data(), bytes.size());
+		job.hash = hashBytes((const char*)settings, sizeof(settings), job.hash);
+
+		auto cached = mCache.find(job.key);
+		if (!mOptions.force && cached != mCache.end() && cached->second == job.hash && fio::exists(job.target)) {
+			job.skipped = true;
+			return;
+		}
+
+		QImage image;
+		if (!image.loadFromData((const uchar*)bytes.data(), (int)bytes.size(), "PNG")) {
+			job.failed = true;
+			return;
+		}
+
+		PixelBlock pixels;
+		pixels.loadFromImage(image);
+
+		job.width = pixels.width;
+		job.height = pixels.height;
+		job.rects = findOpaqueRegions(pixels, mOptions.alphaCut);
+		job.scanMs = elapsedMs(begin);
+	}
+
+	void BatchAtlasGenerator::exportAtlas(Job& job) {
+		auto begin = BatchClock::now();
+
+		auto atlas = gProject.make<AssetData>(-1, job.target, fio::file_time_type())
+			.add<AtlasMeta>().add<Atlas>().add<AssetLoaded>();
+		auto& meta = atlas.get<AtlasMeta>();
+		meta.self = atlas;
+
+		createCellsFromRects(atlas, job.rects, job.width, job.height);
+		sortCellOrderOnNewGen(meta, mOptions.sortorder, mOptions.margin);
+		renameCellsOnNewGen(atlas, job.target.stem().generic_u8string());
+
+		fio::create_directories(job.target.parent_path());
+		atlas->exportFile(job.target, meta);
+		atlas->unload(meta);
+		atlas.destroy();
+
+		job.exportMs = elapsedMs(begin);
+	}
+
+	int BatchAtlasGenerator::run() {
+		auto begin = BatchClock::now();
+		if (!fio::is_directory(mOptions.input)) {
+			cout << "Input is not a directory: " << mOptions.input.generic_u8string() << endl;
+			return 1;
+		}
+
+		collect();
+		loadCache();
+
+		// Decoding and region scanning are pure CPU work; gProject is only touched on this thread below
+		parallelFor(mJobs.size(), [&](sizet i) { scan(mJobs[i]); }, mOptions.threads);
+
+		int generated = 0, skipped = 0, failed = 0;
+		cout << std::fixed << std::setprecision(1);
+		for (auto& job : mJobs) {
+			if (job.failed) {
+				failed++;
+				cout << "[fail] " << job.key << endl;
+			} else if (job.skipped) {
+				skipped++;
+				cout << "[skip] " << job.key << " (unchanged)" << endl;
+			} else {
+				exportAtlas(job);
+				generated++;
+				cout << "[gen]  " << job.key << "  cells " << job.rects.size()
+					<< "  scan " << job.scanMs << "ms  export " << job.exportMs << "ms" << endl;
+			}
+		}
+
+		saveCache();
+		cout << generated << " generated, " << skipped << " skipped, " << failed << " failed in "
+			<< elapsedMs(begin) << "ms" << endl;
+		return failed;
+	}
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <unordered_map>
+#include <atlas/pixel_block.h>
+
+namespace el
+{
+	struct BatchAtlasOptions
+	{
+		fio::path input, output;
+		uint alphaCut, sortorder, margin, threads;
+		bool force;
+
+		BatchAtlasOptions() : alphaCut(10), sortorder(0), margin(10), threads(0), force(false) {}
+	};
+
+	// Headless counterpart of QElangAtlasEditor::newAtlas.
+	// Walks a directory tree for PNGs and writes an .atls next to each one (or mirrored under output),
+	// using the same alpha cut, ordering and naming as the Cells view. Needs no window or GL context.
+	class BatchAtlasGenerator
+	{
+	public:
+		BatchAtlasGenerator(const BatchAtlasOptions& options);
+
+		// Returns the number of files that failed
+		int run();
+
+	private:
+		struct Job
+		{
+			fio::path source, target;
+			string key;
+			uint64_t hash;
+			bool skipped, failed;
+			int width, height;
+			vector<PixelRect> rects;
+			double scanMs, exportMs;
+
+			Job() : hash(0), skipped(false), failed(false), width(0), height(0), scanMs(0), exportMs(0) {}
+		};
+
+		BatchAtlasOptions mOptions;
+		vector<Job> mJobs;
+		std::unordered_map<string, uint64_t> mCache;
+
+		fio::path cachePath();
+		void collect();
+		void loadCache();
+		void saveCache();
+		void scan(Job& job);
+		void exportAtlas(Job& job);
+	};
+}
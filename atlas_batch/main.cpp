@@ -0,0 +1,41 @@
+#include <elqtpch.h>
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include "batch_generator.h"
+
+int main(int argc, char* argv[])
+{
+	QCoreApplication app(argc, argv);
+	QCoreApplication::setApplicationName("elang_atlas_batch");
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Generates .atls files for every PNG under a directory, without opening the editor.");
+	parser.addHelpOption();
+	parser.addPositionalArgument("input", "Directory searched recursively for PNG sprite sheets.");
+
+	QCommandLineOption outputOption({ "o", "output" }, "Write atlases under <dir> instead of next to each PNG.", "dir");
+	QCommandLineOption alphaOption({ "a", "alpha-cut" }, "Alpha values at or below <cut> count as empty.", "cut", "10");
+	QCommandLineOption marginOption({ "m", "margin" }, "Row margin in pixels for cell ordering.", "px", "10");
+	QCommandLineOption orderOption("order", "Cell ordering, 0 is left to right then top to bottom.", "order", "0");
+	QCommandLineOption threadsOption({ "j", "threads" }, "Worker threads, 0 uses every core.", "n", "0");
+	QCommandLineOption forceOption({ "f", "force" }, "Regenerate even when the content hash is unchanged.");
+	parser.addOptions({ outputOption, alphaOption, marginOption, orderOption, threadsOption, forceOption });
+	parser.process(app);
+
+	auto args = parser.positionalArguments();
+	if (args.size() != 1)
+		parser.showHelp(1);
+
+	el::BatchAtlasOptions options;
+	options.input = args[0].toStdU16String();
+	if (parser.isSet(outputOption))
+		options.output = parser.value(outputOption).toStdU16String();
+	options.alphaCut = parser.value(alphaOption).toUInt();
+	options.margin = parser.value(marginOption).toUInt();
+	options.sortorder = parser.value(orderOption).toUInt();
+	options.threads = parser.value(threadsOption).toUInt();
+	options.force = parser.isSet(forceOption);
+
+	el::BatchAtlasGenerator generator(options);
+	return generator.run() == 0 ? 0 : 2;
+}
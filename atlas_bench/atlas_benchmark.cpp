@@ -0,0 +1,299 @@
+#include <elqtpch.h>
+#include "atlas_benchmark.h"
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <random>
+#include <tools/cell.h>
+#include <tools/atlas.h>
+#include <atlas/atlas_gen.h>
+#include <atlas/util.h>
+#include <elqt/widget/cell_holders.h>
+
+namespace el
+{
+	using BenchClock = std::chrono::steady_clock;
+
+	// Mouse moves per hit-test sample and rubber bands per selection sample
+	static const int cHitPoints = 256;
+	static const int cSelectRects = 64;
+	// Names asked for per naming sample, each one added to the list like Create Cell does
+	static const int cNamedCells = 100;
+
+	struct HoverCounter : IButtonEvent
+	{
+		sizet hovers = 0;
+
+		void onEnter(Entity self, Entity context) override {};
+		void onHover(Entity self, Entity context) override { hovers++; };
+		void onExit(Entity self, Entity context) override {};
+		void postUpdate(Entity self, Entity context) override {};
+	};
+
+	template<typename Func>
+	static double timeMs(Func&& func) {
+		auto begin = BenchClock::now();
+		func();
+		return std::chrono::duration<double, std::milli>(BenchClock::now() - begin).count();
+	}
+
+	AtlasBenchmark::AtlasBenchmark(const AtlasBenchmarkOptions& options) : mOptions(options), mFailures(0) {}
+
+	bool AtlasBenchmark::enabled(const string& name) const {
+		return mOptions.filter.empty() || name.find(mOptions.filter) != string::npos;
+	}
+
+	AtlasBenchmark::Result& AtlasBenchmark::result(const string& name, sizet cells) {
+		for (auto& result : mResults) {
+			if (result.name == name && result.cells == cells)
+				return result;
+		}
+		mResults.push_back({ name, cells, mOptions.textureSize, {} });
+		return mResults.back();
+	}
+
+	void AtlasBenchmark::makeSheet(sizet cells, PixelBlock& sheet) {
+		int size = mOptions.textureSize;
+		int columns = (int)ceil(sqrt((double)cells));
+		int pitch = size / max(columns, 1);
+
+		sheet = PixelBlock();
+		// Every blob needs a pixel and a one pixel gap so it stays its own region
+		if (pitch < 2)
+			return;
+
+		sheet.width = size;
+		sheet.height = size;
+		sheet.rgba.assign((sizet)size * size * 4, 0);
+
+		std::mt19937 rng((uint)cells);
+		int minSide = max(1, pitch / 2), maxSide = pitch - 1;
+		for (sizet i = 0; i < cells; i++) {
+			int w = minSide + (int)(rng() % (maxSide - minSide + 1));
+			int h = minSide + (int)(rng() % (maxSide - minSide + 1));
+			int x = (int)(i % columns) * pitch + (int)(rng() % (pitch - w));
+			int y = (int)(i / columns) * pitch + (int)(rng() % (pitch - h));
+
+			unsigned char color[4] = { (unsigned char)(i * 37), (unsigned char)(i * 91), (unsigned char)(i * 173), 255 };
+			for (int py = y; py < y + h; py++) {
+				auto row = &sheet.rgba[((sizet)py * size + x) * 4];
+				for (int px = 0; px < w; px++)
+					memcpy(row + px * 4, color, 4);
+			}
+		}
+	}
+
+	void AtlasBenchmark::runSize(sizet cells) {
+		PixelBlock sheet;
+		makeSheet(cells, sheet);
+		if (sheet.empty()) {
+			cout << "[fail] " << cells << " cells don't fit a " << mOptions.textureSize << " texture" << endl;
+			mFailures++;
+			return;
+		}
+
+		// Auto Cell fills one region at a time with this same rule, New Atlas fills them all
+		vector<PixelRect> rects;
+		for (uint run = 0; run < mOptions.runs && enabled("flood_fill"); run++)
+			result("flood_fill", cells).samples.push_back(timeMs([&]() { rects = findOpaqueRegions(sheet, mOptions.alphaCut); }));
+		if (rects.empty())
+			rects = findOpaqueRegions(sheet, mOptions.alphaCut);
+		sheet = PixelBlock();
+
+		if (rects.size() != cells) {
+			cout << "[fail] flood fill found " << rects.size() << " regions, expected " << cells << endl;
+			mFailures++;
+		}
+
+		auto scratch = mOptions.scratch.empty() ? fio::temp_directory_path() : mOptions.scratch;
+		auto path = scratch / ("elang_atlas_bench_" + std::to_string(cells) + ".atls");
+		std::mt19937 rng((uint)cells);
+		auto size = mOptions.textureSize;
+
+		for (uint run = 0; run < mOptions.runs; run++) {
+			auto atlas = gProject.make<AssetData>(-1, path, fio::file_time_type())
+				.add<AtlasMeta>().add<Atlas>().add<AssetLoaded>();
+			auto& meta = atlas.get<AtlasMeta>();
+			meta.self = atlas;
+
+			auto generate = timeMs([&]() { createCellsFromRects(atlas, rects, size, size); });
+			if (enabled("auto_generate"))
+				result("auto_generate", cells).samples.push_back(generate);
+
+			// Regions come out in scan order, which is nearly sorted already; an edited atlas is not
+			std::shuffle(meta.cellorder.begin(), meta.cellorder.end(), rng);
+			auto sort = timeMs([&]() { sortCellOrderOnNewGen(meta, 0, 10); });
+			if (enabled("sort_new_gen"))
+				result("sort_new_gen", cells).samples.push_back(sort);
+
+			auto rename = timeMs([&]() { renameCellsOnNewGen(atlas, path.stem().generic_u8string()); });
+			if (enabled("rename_new_gen"))
+				result("rename_new_gen", cells).samples.push_back(rename);
+
+			// The palette's own holders, with a button target that only counts hovers
+			HoverCounter counter;
+			auto holders = timeMs([&]() { createCellHolders(atlas, &counter); });
+			if (enabled("palette_holders"))
+				result("palette_holders", cells).samples.push_back(holders);
+
+			// Each point is one mouse move through QElangPaletteWidget::updateAllHolderCheck
+			if (enabled("hit_test")) {
+				vector<vec2> points(cHitPoints);
+				for (auto& point : points)
+					point = vec2((float)(rng() % size), -(float)(rng() % size));
+
+				counter.hovers = 0;
+				result("hit_test", cells).samples.push_back(timeMs([&]() {
+					for (auto& point : points)
+						updateCellHolderButtons(meta, point);
+				}));
+				if (counter.hovers > points.size()) {
+					cout << "[fail] hit test found overlapping cells" << endl;
+					mFailures++;
+				}
+			}
+
+			// Rubber band selection as the Cells view does it on mouse release
+			if (enabled("select_rect")) {
+				vector<Box> bands(cSelectRects);
+				for (auto& band : bands) {
+					float l = (float)(rng() % size), t = (float)(rng() % size);
+					float w = (float)(rng() % (size / 4 + 1)), h = (float)(rng() % (size / 4 + 1));
+					band = Box(l, -(t + h), l + w, -t);
+				}
+
+				result("select_rect", cells).samples.push_back(timeMs([&]() {
+					for (auto& band : bands)
+						selectCellHolders<AtlasSelectedCell>(meta, band);
+				}));
+			}
+
+			// The walk of QElangPaletteWidget::rebatchCellShapes with the whole sheet in view at one texel per pixel
+			// and a quarter of it selected. batchAABB itself needs GL and is left to the in-editor frame profiler,
+			// here outlines are four edges and fills two triangles
+			if (enabled("rebatch_geometry")) {
+				Box region(0.0f, -(float)size, (float)size, 0.0f);
+				selectCellHolders<PaletteSelectedCell>(meta, Box(0.0f, -(float)size / 2, (float)size / 2, 0.0f));
+
+				vector<vec2> lines, fills;
+				auto outline = [&](const Box& r) {
+					vec2 corners[4] = { vec2(r.l, r.b), vec2(r.r, r.b), vec2(r.r, r.t), vec2(r.l, r.t) };
+					for (int c = 0; c < 4; c++) {
+						lines.push_back(corners[c]);
+						lines.push_back(corners[(c + 1) % 4]);
+					}
+				};
+				auto fill = [&](const Box& r) {
+					vec2 quad[6] = { vec2(r.l, r.b), vec2(r.r, r.b), vec2(r.r, r.t), vec2(r.l, r.b), vec2(r.r, r.t), vec2(r.l, r.t) };
+					fills.insert(fills.end(), quad, quad + 6);
+				};
+				result("rebatch_geometry", cells).samples.push_back(timeMs([&]() {
+					walkCellOutlines<PaletteSelectedCell>(atlas, region, 1.0f, 4.0f, outline, fill, fill);
+				}));
+				gProject.clear<PaletteSelectedCell>();
+			}
+			gProject.clear<AtlasSelectedCell>();
+
+			auto exported = timeMs([&]() { atlas->exportFile(path, meta); });
+			if (enabled("export"))
+				result("export", cells).samples.push_back(exported);
+			atlas->unload(meta);
+			atlas.destroy();
+
+			if (enabled("import")) {
+				auto loaded = gProject.make<AssetData>(-1, path, fio::file_time_type())
+					.add<AtlasMeta>().add<Atlas>().add<AssetLoaded>();
+				auto& loadedMeta = loaded.get<AtlasMeta>();
+				loadedMeta.self = loaded;
+				result("import", cells).samples.push_back(timeMs([&]() { loaded->importFile(path, loadedMeta); }));
+				if (loadedMeta.cellorder.size() != rects.size()) {
+					cout << "[fail] imported " << loadedMeta.cellorder.size() << " cells, expected " << rects.size() << endl;
+					mFailures++;
+				}
+				loaded->unload(loadedMeta);
+				loaded.destroy();
+			}
+		}
+		fio::remove(path);
+
+		// Creating cells one by one asks the list for a free name each time, a linear scan of every item
+		if (enabled("unique_names")) {
+			QListExtension list(nullptr);
+			for (sizet i = 0; i < cells; i++)
+				list.addItem("cell_" + QString::number(i));
+
+			for (uint run = 0; run < mOptions.runs; run++) {
+				result("unique_names", cells).samples.push_back(timeMs([&]() {
+					for (int i = 0; i < cNamedCells; i++)
+						list.addItem(list.getNoneConflictingName("cell", false));
+				}));
+				while ((sizet)list.count() > cells)
+					delete list.takeItem(list.count() - 1);
+			}
+		}
+	}
+
+	void AtlasBenchmark::report() {
+		cout << std::fixed << std::setprecision(3);
+		cout << std::left << std::setw(18) << "benchmark" << std::right << std::setw(8) << "cells"
+			<< std::setw(12) << "min ms" << std::setw(12) << "median ms" << std::setw(12) << "max ms" << endl;
+		for (auto& result : mResults) {
+			auto samples = result.samples;
+			std::sort(samples.begin(), samples.end());
+			cout << std::left << std::setw(18) << result.name << std::right << std::setw(8) << result.cells
+				<< std::setw(12) << samples.front() << std::setw(12) << samples[samples.size() / 2]
+				<< std::setw(12) << samples.back() << endl;
+		}
+	}
+
+	bool AtlasBenchmark::writeJson() {
+		std::ofstream out(mOptions.output, std::ios::binary);
+		if (!out)
+			return false;
+
+		out << std::fixed << std::setprecision(4);
+		out << "{\n\"suite\": \"elang_atlas_bench\",\n\"texture\": " << mOptions.textureSize
+			<< ",\n\"runs\": " << mOptions.runs << ",\n\"failures\": " << mFailures << ",\n\"results\": [";
+		for (sizet i = 0; i < mResults.size(); i++) {
+			auto samples = mResults[i].samples;
+			std::sort(samples.begin(), samples.end());
+			double total = 0.0;
+			for (auto sample : samples)
+				total += sample;
+
+			out << (i > 0 ? "," : "") << "\n{\"name\": \"" << mResults[i].name << "\", \"cells\": " << mResults[i].cells
+				<< ", \"texture\": " << mResults[i].textureSize
+				<< ", \"min_ms\": " << samples.front() << ", \"median_ms\": " << samples[samples.size() / 2]
+				<< ", \"mean_ms\": " << total / samples.size() << ", \"max_ms\": " << samples.back()
+				<< ", \"samples_ms\": [";
+			for (sizet s = 0; s < mResults[i].samples.size(); s++)
+				out << (s > 0 ? ", " : "") << mResults[i].samples[s];
+			out << "]}";
+		}
+		out << "\n]\n}\n";
+		return (bool)out;
+	}
+
+	int AtlasBenchmark::run() {
+		if (mOptions.runs == 0)
+			mOptions.runs = 1;
+
+		for (auto cells : mOptions.cells) {
+			cout << "Running " << cells << " cells on " << mOptions.textureSize << "x" << mOptions.textureSize << "..." << endl;
+			runSize(cells);
+		}
+
+		if (mResults.size() > 0)
+			report();
+		if (!mOptions.output.empty()) {
+			if (writeJson())
+				cout << "Results written to " << mOptions.output.generic_u8string() << endl;
+			else {
+				cout << "Failed to write " << mOptions.output.generic_u8string() << endl;
+				mFailures++;
+			}
+		}
+		return mFailures;
+	}
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <atlas/pixel_block.h>
+
+namespace el
+{
+	struct AtlasBenchmarkOptions
+	{
+		vector<sizet> cells;
+		int textureSize;
+		uint runs, alphaCut;
+		fio::path output, scratch;
+		string filter;
+
+		AtlasBenchmarkOptions() : cells{ 1000, 10000, 100000 }, textureSize(4096), runs(5), alphaCut(10) {}
+	};
+
+	// Times the Cells view and palette hot paths on synthetic sprite sheets, without a window or GL context.
+	// Every sheet holds exactly the requested number of separated blobs on a square texture, so the cell count and
+	// texture size can be varied independently. Results go to the console and, when output is set, to a JSON file
+	class AtlasBenchmark
+	{
+	public:
+		AtlasBenchmark(const AtlasBenchmarkOptions& options);
+
+		// Returns the number of checks that failed
+		int run();
+
+	private:
+		struct Result
+		{
+			string name;
+			sizet cells;
+			int textureSize;
+			vector<double> samples;
+		};
+
+		AtlasBenchmarkOptions mOptions;
+		vector<Result> mResults;
+		int mFailures;
+
+		bool enabled(const string& name) const;
+		Result& result(const string& name, sizet cells);
+		void makeSheet(sizet cells, PixelBlock& sheet);
+		void runSize(sizet cells);
+		void report();
+		bool writeJson();
+	};
+}
@@ -0,0 +1,43 @@
+#include <elqtpch.h>
+#include <QCommandLineParser>
+#include "atlas_benchmark.h"
+
+int main(int argc, char* argv[])
+{
+	// The naming benchmark needs a list widget, which still works without a display on the offscreen platform
+	if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+		qputenv("QT_QPA_PLATFORM", "offscreen");
+
+	QApplication app(argc, argv);
+	QCoreApplication::setApplicationName("elang_atlas_bench");
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Times the atlas editor hot paths on synthetic sprite sheets.");
+	parser.addHelpOption();
+
+	QCommandLineOption cellsOption({ "c", "cells" }, "Comma separated cell counts, one sheet each.", "list", "1000,10000,100000");
+	QCommandLineOption sizeOption({ "s", "size" }, "Texture width and height in pixels, up to 16384.", "px", "4096");
+	QCommandLineOption runsOption({ "r", "runs" }, "Samples taken of every benchmark.", "n", "5");
+	QCommandLineOption alphaOption({ "a", "alpha-cut" }, "Alpha values at or below <cut> count as empty.", "cut", "10");
+	QCommandLineOption outputOption({ "o", "output" }, "Write the results as JSON to <file>.", "file");
+	QCommandLineOption scratchOption("scratch", "Directory for the exported atlas, the temp directory by default.", "dir");
+	QCommandLineOption filterOption({ "f", "filter" }, "Only run benchmarks whose name contains <text>.", "text");
+	parser.addOptions({ cellsOption, sizeOption, runsOption, alphaOption, outputOption, scratchOption, filterOption });
+	parser.process(app);
+
+	el::AtlasBenchmarkOptions options;
+	options.cells.clear();
+	for (auto& count : parser.value(cellsOption).split(',', Qt::SkipEmptyParts))
+		options.cells.push_back(count.trimmed().toULongLong());
+	options.textureSize = std::clamp(parser.value(sizeOption).toInt(), 16, 16384);
+	options.runs = parser.value(runsOption).toUInt();
+	options.alphaCut = parser.value(alphaOption).toUInt();
+	if (parser.isSet(outputOption))
+		options.output = parser.value(outputOption).toStdU16String();
+	if (parser.isSet(scratchOption))
+		options.scratch = parser.value(scratchOption).toStdU16String();
+	options.filter = parser.value(filterOption).toStdString();
+
+	el::AtlasBenchmark benchmark(options);
+	return benchmark.run() == 0 ? 0 : 2;
+}
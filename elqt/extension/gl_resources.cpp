@@ -0,0 +1,397 @@
+#include <elqtpch.h>
+#include "gl_resources.h"
+
+#include <apparatus/ui.h>
+#include <tools/painter.h>
+#include <tools/project.h>
+#include <elements/sprite.h>
+#include <QOpenGLContext>
+#include <QOffscreenSurface>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstring>
+
+namespace el
+{
+	namespace
+	{
+		fio::path sShaderCacheDirectory;
+
+		// Painter and ShapeDebug2d compile and link inside their init, out of reach of this tree. While one of them
+		// is made, the GLEW entry points below are swapped for versions that record the shader sources and turn
+		// glLinkProgram into glProgramBinary when a binary for the same sources and driver was saved before
+		struct ProgramCacheScope
+		{
+			ProgramCacheScope() : active(!sShaderCacheDirectory.empty() && GLEW_ARB_get_program_binary) {
+				if (!active)
+					return;
+				sShaderSource = __glewShaderSource;
+				sAttachShader = __glewAttachShader;
+				sLinkProgram = __glewLinkProgram;
+				__glewShaderSource = shaderSource;
+				__glewAttachShader = attachShader;
+				__glewLinkProgram = linkProgram;
+			}
+
+			~ProgramCacheScope() {
+				if (!active)
+					return;
+				__glewShaderSource = sShaderSource;
+				__glewAttachShader = sAttachShader;
+				__glewLinkProgram = sLinkProgram;
+				sSources.clear();
+				sAttached.clear();
+			}
+
+			bool active;
+
+			static inline PFNGLSHADERSOURCEPROC sShaderSource = 0;
+			static inline PFNGLATTACHSHADERPROC sAttachShader = 0;
+			static inline PFNGLLINKPROGRAMPROC sLinkProgram = 0;
+			static inline std::unordered_map<GLuint, string> sSources;
+			static inline std::unordered_map<GLuint, vector<GLuint>> sAttached;
+
+			static void GLAPIENTRY shaderSource(GLuint shader, GLsizei count, const GLchar* const* strings, const GLint* lengths) {
+				string source;
+				for (GLsizei i = 0; i < count; i++)
+					source.append(strings[i], (lengths && lengths[i] >= 0) ? (sizet)lengths[i] : strlen(strings[i]));
+				sSources[shader] = source;
+				sShaderSource(shader, count, strings, lengths);
+			}
+
+			static void GLAPIENTRY attachShader(GLuint program, GLuint shader) {
+				sAttached[program].push_back(shader);
+				sAttachShader(program, shader);
+			}
+
+			static void GLAPIENTRY linkProgram(GLuint program) {
+				// The driver strings are part of the key, a driver update never gets handed an old binary
+				uint64_t key = 14695981039346656037ull;
+				auto mix = [&](const string& text) {
+					for (auto c : text)
+						key = (key ^ (unsigned char)c) * 1099511628211ull;
+					key = (key ^ 0xff) * 1099511628211ull;
+				};
+				for (auto name : { GL_VENDOR, GL_RENDERER, GL_VERSION }) {
+					auto text = (const char*)glGetString(name);
+					mix(text ? text : "");
+				}
+				for (auto shader : sAttached[program])
+					mix(sSources[shader]);
+				sAttached.erase(program);
+
+				std::stringstream name;
+				name << std::hex << std::setw(16) << std::setfill('0') << key << ".bin";
+				auto path = sShaderCacheDirectory / name.str();
+				if (loadBinary(program, path))
+					return;
+
+				glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+				sLinkProgram(program);
+				saveBinary(program, path);
+			}
+
+			static bool loadBinary(GLuint program, const fio::path& path) {
+				std::ifstream file(path, std::ios::binary);
+				GLenum format = 0;
+				if (!file.read((char*)&format, sizeof(format)))
+					return false;
+				vector<char> binary((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+				if (binary.empty())
+					return false;
+
+				glProgramBinary(program, format, binary.data(), (GLsizei)binary.size());
+				GLint linked = GL_FALSE;
+				glGetProgramiv(program, GL_LINK_STATUS, &linked);
+				if (linked == GL_TRUE)
+					return true;
+
+				// Rejected binaries fall back to a normal link, which writes a fresh one
+				file.close();
+				std::error_code ec;
+				fio::remove(path, ec);
+				return false;
+			}
+
+			static void saveBinary(GLuint program, const fio::path& path) {
+				GLint linked = GL_FALSE, length = 0;
+				glGetProgramiv(program, GL_LINK_STATUS, &linked);
+				glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+				if (linked != GL_TRUE || length <= 0)
+					return;
+
+				vector<char> binary((sizet)length);
+				GLenum format = 0;
+				glGetProgramBinary(program, length, &length, &format, binary.data());
+				std::ofstream file(path, std::ios::binary);
+				file.write((const char*)&format, sizeof(format));
+				file.write(binary.data(), length);
+				if (!file)
+					cout << "Failed to write program binary " << path.generic_u8string() << endl;
+			}
+		};
+	}
+
+	void QElangGLResources::enableShaderDiskCache(const fio::path& directory) {
+		std::error_code ec;
+		fio::create_directories(directory, ec);
+		if (ec) {
+			cout << "Shader cache disabled, cannot create " << directory.generic_u8string() << endl;
+			return;
+		} sShaderCacheDirectory = fio::absolute(directory, ec);
+	}
+
+	namespace
+	{
+		// Runs func with no context current, so GL objects of a resource whose context is gone can't be mistaken
+		// for names of whichever view happens to be current. Whatever was current is restored afterwards
+		template<typename F>
+		void withoutContext(F func) {
+			auto previous = QOpenGLContext::currentContext();
+			auto surface = previous ? previous->surface() : 0;
+			if (previous)
+				previous->doneCurrent();
+			func();
+			if (previous)
+				previous->makeCurrent(surface);
+		}
+	}
+
+	QOpenGLContext* QElangGLResources::watchCurrentContext() {
+		auto context = QOpenGLContext::currentContext();
+		if (context && mContexts.insert(context).second)
+			QObject::connect(context, &QOpenGLContext::aboutToBeDestroyed, context, [this, context]() { dropContext(context); }, Qt::DirectConnection);
+		return context;
+	}
+
+	void QElangGLResources::dropContext(QOpenGLContext* context) {
+		// Nothing is current when QOpenGLWidget tears its context down, so the dying context is made current
+		// on a throwaway surface for the pooled painters to free their vertex arrays in the right place
+		auto previous = QOpenGLContext::currentContext();
+		auto previousSurface = previous ? previous->surface() : 0;
+		QOffscreenSurface surface;
+		surface.setFormat(context->format());
+		surface.create();
+		bool current = context->makeCurrent(&surface);
+		if (!current)
+			cout << "Could not make a closing GL context current, its pooled painters are leaked" << endl;
+
+		for (auto painter : mFreePainters[context]) {
+			mCapacity.erase(painter);
+			mPainterContext.erase(painter);
+			if (current)
+				painter.destroy();
+		}
+		for (auto shapes : mFreeShapes[context]) {
+			mShapeContext.erase(shapes);
+			if (current)
+				delete shapes;
+		}
+		mFreePainters.erase(context);
+		mFreeShapes.erase(context);
+		mContexts.erase(context);
+
+		if (current)
+			context->doneCurrent();
+		if (previous && previous != context)
+			previous->makeCurrent(previousSurface);
+
+		// Views release with their own context current, so anything still in use here outlived it.
+		// Those are freed without a context on release instead of pooled
+		for (auto& pair : mPainterContext)
+			if (pair.second == context)
+				pair.second = 0;
+		for (auto& pair : mShapeContext)
+			if (pair.second == context)
+				pair.second = 0;
+	}
+
+	asset<Painter> QElangGLResources::acquireSpritePainter(sizet capacity, asset<Camera> camera) {
+		auto context = watchCurrentContext();
+		auto& pool = mFreePainters[context];
+		auto best = pool.end();
+		for (auto it = pool.begin(); it != pool.end(); it++) {
+			auto size = mCapacity[*it];
+			if (size >= capacity && (best == pool.end() || size < mCapacity[*best]))
+				best = it;
+		}
+
+		if (best != pool.end()) {
+			auto painter = *best;
+			*best = pool.back();
+			pool.pop_back();
+			painter->camera = camera;
+			painter->color = vec4(1.0f, 1.0f, 1.0f, 1.0f);
+			return painter;
+		}
+
+		auto painter = gProject.make<Painter>("__el_editor_/shader/basic_sprite.vert", "__el_editor_/shader/texture_uv.frag",
+			capacity, camera, Projection::eOrtho,
+			ePainterFlags::DEPTH_SORT | ePainterFlags::MULTI_MATERIAL | ePainterFlags::Z_CLEAR).add<EditorAsset>();
+		{
+			ProgramCacheScope cache;
+			painter->init();
+		}
+		mCapacity[painter] = capacity;
+		mPainterContext[painter] = context;
+		return painter;
+	}
+
+	ShapeDebug2d* QElangGLResources::acquireShapes(asset<Camera> camera) {
+		auto context = watchCurrentContext();
+		auto& pool = mFreeShapes[context];
+		if (pool.size() > 0) {
+			auto shapes = pool.back();
+			pool.pop_back();
+			shapes->line.camera = camera;
+			shapes->fill.camera = camera;
+			return shapes;
+		}
+
+		auto shapes = new ShapeDebug2d;
+		{
+			ProgramCacheScope cache;
+			shapes->init(camera);
+		}
+		mShapeContext[shapes] = context;
+		return shapes;
+	}
+
+	void QElangGLResources::release(asset<Painter>& painter) {
+		if (!painter)
+			return;
+
+		mLowUse.erase(painter);
+		auto it = mPainterContext.find(painter);
+		// Painters made elsewhere are simply destroyed, ones whose context is gone without any context current
+		if (it == mPainterContext.end()) {
+			mCapacity.erase(painter);
+			painter.destroy();
+		} else if (!it->second) {
+			mPainterContext.erase(it);
+			mCapacity.erase(painter);
+			withoutContext([&]() { painter.destroy(); });
+		} else {
+			painter->forceUnlock();
+			painter->camera = NullEntity;
+			mFreePainters[it->second].push_back(painter);
+		} painter = asset<Painter>();
+	}
+
+	void QElangGLResources::release(ShapeDebug2d*& shapes) {
+		if (!shapes)
+			return;
+
+		auto it = mShapeContext.find(shapes);
+		if (it == mShapeContext.end()) {
+			delete shapes;
+		} else if (!it->second) {
+			mShapeContext.erase(it);
+			withoutContext([&]() { delete shapes; });
+		} else {
+			shapes->line.forceUnlock();
+			shapes->fill.forceUnlock();
+			shapes->line.camera = NullEntity;
+			shapes->fill.camera = NullEntity;
+			mFreeShapes[it->second].push_back(shapes);
+		} shapes = 0;
+	}
+
+	sizet QElangGLResources::freePainterCount() const {
+		sizet count = 0;
+		for (auto& pair : mFreePainters)
+			count += pair.second.size();
+		return count;
+	}
+
+	bool QElangGLResources::pooled(asset<Painter> painter) const {
+		for (auto& pair : mFreePainters)
+			if (std::find(pair.second.begin(), pair.second.end(), painter) != pair.second.end())
+				return true;
+		return false;
+	}
+
+	sizet QElangGLResources::capacity(asset<Painter> painter) const {
+		auto it = mCapacity.find(painter);
+		return (it != mCapacity.end()) ? it->second : 0;
+	}
+
+	asset<Painter> QElangGLResources::swap(asset<Painter>& painter, sizet capacity) {
+		auto camera = painter->camera;
+		auto old = painter;
+		mLowUse.erase(old);
+		painter = acquireSpritePainter(capacity, camera);
+		return old;
+	}
+
+	bool QElangGLResources::reserve(asset<Painter>& painter, sizet capacity) {
+		auto current = this->capacity(painter);
+		if (!painter || current >= capacity)
+			return false;
+
+		sizet grown = max(cMinCapacity, current * 2);
+		while (grown < capacity)
+			grown *= 2;
+		auto old = swap(painter, grown);
+		release(old);
+		return true;
+	}
+
+	bool QElangGLResources::trim(asset<Painter>& painter, sizet used) {
+		auto current = capacity(painter);
+		if (!painter || current <= cMinCapacity)
+			return false;
+
+		if (used * 4 >= current) {
+			mLowUse.erase(painter);
+			return false;
+		}
+
+		auto now = std::chrono::steady_clock::now();
+		auto it = mLowUse.find(painter);
+		if (it == mLowUse.end()) {
+			mLowUse.emplace(painter, LowUse{ now, used });
+			return false;
+		}
+
+		it->second.peak = max(it->second.peak, used);
+		if (std::chrono::duration_cast<std::chrono::milliseconds>(now - it->second.since).count() < cShrinkDelayMs)
+			return false;
+
+		sizet shrunk = cMinCapacity;
+		while (shrunk < it->second.peak * 2)
+			shrunk *= 2;
+		if (shrunk >= current) {
+			mLowUse.erase(it);
+			return false;
+		}
+
+		// The large painter is what the shrink is meant to free, so it doesn't wait in the pool
+		auto old = swap(painter, shrunk);
+		mCapacity.erase(old);
+		mPainterContext.erase(old);
+		old.destroy();
+		return true;
+	}
+
+	void QElangGLResources::reportMemory(vector<MemoryUsage>& rows) const {
+		// The vertex array is kept on both sides: batched on the CPU, then uploaded into a buffer of the same capacity
+		for (auto& pair : mCapacity) {
+			bool pooled = this->pooled(asset<Painter>(pair.first));
+			auto bytes = pair.second * sizeof(SpriteVertex);
+			rows.push_back({ "Painters", "Sprite painter " + std::to_string((uint)pair.first) + " (" + std::to_string(pair.second)
+				+ " vertices, " + (pooled ? "pooled)" : "in use)"), bytes, bytes, true });
+		}
+
+		// ShapeDebug2d doesn't expose its buffer capacity, only the objects themselves are counted
+		if (mShapeContext.size() > 0) {
+			sizet free = 0;
+			for (auto& pair : mFreeShapes)
+				free += pair.second.size();
+			rows.push_back({ "Painters", "Debug shape sets (" + std::to_string(mShapeContext.size()) + ", " + std::to_string(free) + " pooled)",
+				mShapeContext.size() * sizeof(ShapeDebug2d), 0, true });
+		}
+	}
+}
@@ -0,0 +1,92 @@
+/*****************************************************************//**
+ * @file   gl_resources.h
+ * @brief  Painters and debug shapes pooled for the editor views
+ *		   Painter and ShapeDebug2d compile their own program and make their own vertex array object in init,
+ *		   and a VAO only exists in the context that made it, so a painter can't move between views.
+ *		   Views acquire their painters here and hand them back when they are released. Free painters
+ *		   are pooled per context and freed when that context is destroyed, so the swaps done by
+ *		   reserve and trim skip the shader compile and buffer allocation. A new view, a palette dialog
+ *		   included, compiles its own; the share group only lets every view draw the same textures.
+ *
+ *********************************************************************/
+#pragma once
+#include <tools/asset.h>
+#include <tools/camera.h>
+#include "memory_usage.h"
+
+#include <unordered_map>
+#include <unordered_set>
+#include <chrono>
+
+class QOpenGLContext;
+
+namespace el
+{
+	struct Painter;
+	struct ShapeDebug2d;
+
+	struct QElangGLResources
+	{
+		// A sprite or canvas takes four vertices
+		static constexpr sizet cSpriteVertices = 4;
+		// Smallest painter handed out by reserve and trim
+		static constexpr sizet cMinCapacity = 64;
+		// A painter used under a quarter of its capacity this long is swapped for a smaller one
+		static constexpr int cShrinkDelayMs = 10000;
+
+		// Programs linked while a painter or shape set is made here are saved under directory with glGetProgramBinary,
+		// keyed by their shader sources and the driver strings, and later runs load them with glProgramBinary
+		// instead of linking. Without ARB_get_program_binary, or when the driver rejects a binary, they link as usual.
+		// Painters made outside this class are unaffected
+		static void enableShaderDiskCache(const fio::path& directory);
+
+		// Sprite painter with the editor shaders, the smallest free one from the current context that holds
+		// capacity vertices or a new one. The view's GL context must be current
+		asset<Painter> acquireSpritePainter(sizet capacity, asset<Camera> camera);
+		ShapeDebug2d* acquireShapes(asset<Camera> camera);
+
+		// Keeps the resource for the next acquire from the context that created it and clears the handle.
+		// Resources whose context is already gone are destroyed
+		void release(asset<Painter>& painter);
+		void release(ShapeDebug2d*& shapes);
+
+		// Painters can't be resized, so these swap the handle for another painter with the same camera.
+		// Both return true when they did; sprites and canvases holding the old handle must be pointed at the new one.
+		// A GL context must be current
+
+		// Grows painter to hold capacity vertices, at least doubling it. The smaller one goes back to the pool
+		bool reserve(asset<Painter>& painter, sizet capacity);
+		// Reports the vertices the last batch used. After cShrinkDelayMs under a quarter of the capacity, painter is
+		// swapped for one twice the recent peak and the large one is destroyed instead of pooled
+		bool trim(asset<Painter>& painter, sizet used);
+		sizet capacity(asset<Painter> painter) const;
+
+		sizet painterCount() const { return mCapacity.size(); }
+		sizet freePainterCount() const;
+		// One row per pooled painter and shape set, painters in use and waiting for reuse alike
+		void reportMemory(vector<MemoryUsage>& rows) const;
+
+	private:
+		struct LowUse
+		{
+			std::chrono::steady_clock::time_point since;
+			sizet peak;
+		};
+
+		asset<Painter> swap(asset<Painter>& painter, sizet capacity);
+		QOpenGLContext* watchCurrentContext();
+		void dropContext(QOpenGLContext* context);
+		bool pooled(asset<Painter> painter) const;
+
+		std::unordered_map<Entity, sizet> mCapacity;
+		std::unordered_map<Entity, LowUse> mLowUse;
+		// Context each resource was created in, null once that context is destroyed
+		std::unordered_map<Entity, QOpenGLContext*> mPainterContext;
+		std::unordered_map<ShapeDebug2d*, QOpenGLContext*> mShapeContext;
+		std::unordered_map<QOpenGLContext*, vector<asset<Painter>>> mFreePainters;
+		std::unordered_map<QOpenGLContext*, vector<ShapeDebug2d*>> mFreeShapes;
+		std::unordered_set<QOpenGLContext*> mContexts;
+	};
+
+	inline QElangGLResources gEditorGL;
+}
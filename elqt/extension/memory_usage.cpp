@@ -0,0 +1,41 @@
+#include <elqtpch.h>
+#include "memory_usage.h"
+
+#include <tools/texture.h>
+#include <algorithm>
+
+namespace el
+{
+	void QElangMemoryUsage::addReporter(const void* owner, Reporter reporter) {
+		removeReporter(owner);
+		mReporters.emplace_back(owner, std::move(reporter));
+	}
+
+	void QElangMemoryUsage::removeReporter(const void* owner) {
+		mReporters.erase(std::remove_if(mReporters.begin(), mReporters.end(),
+			[&](const std::pair<const void*, Reporter>& pair) { return pair.first == owner; }), mReporters.end());
+	}
+
+	vector<MemoryUsage> QElangMemoryUsage::collect() const {
+		vector<MemoryUsage> rows;
+		for (auto& pair : mReporters)
+			pair.second(rows);
+		std::stable_sort(rows.begin(), rows.end(), [](const MemoryUsage& lhs, const MemoryUsage& rhs) {
+			return lhs.total() > rhs.total();
+		});
+		return rows;
+	}
+
+	sizet QElangMemoryUsage::totalBytes() const {
+		sizet total = 0;
+		for (auto& row : collect())
+			total += row.total();
+		return total;
+	}
+
+	sizet QElangMemoryUsage::textureBytes(asset<Texture> tex) {
+		if (!tex || !tex.has<AssetLoaded>())
+			return 0;
+		return (sizet)tex->width() * tex->height() * 4;
+	}
+}
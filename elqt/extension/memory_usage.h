@@ -0,0 +1,46 @@
+/*****************************************************************//**
+ * @file   memory_usage.h
+ * @brief  Bytes held by each editor asset, reported by whoever owns it
+ *		   Owners register a reporter that appends one row per asset; collect() asks all of them.
+ *		   Rows marked estimate are computed from capacities and element sizes rather than read back from GL.
+ *
+ *********************************************************************/
+#pragma once
+#include <tools/asset.h>
+
+#include <functional>
+
+namespace el
+{
+	struct Texture;
+
+	struct MemoryUsage
+	{
+		string group, name;
+		sizet cpuBytes, gpuBytes;
+		bool estimate;
+
+		sizet total() const { return cpuBytes + gpuBytes; }
+	};
+
+	struct QElangMemoryUsage
+	{
+		using Reporter = std::function<void(vector<MemoryUsage>&)>;
+
+		// owner is any address unique to the reporter, it removes the reporter again
+		void addReporter(const void* owner, Reporter reporter);
+		void removeReporter(const void* owner);
+
+		// One row per asset from every reporter, largest first
+		vector<MemoryUsage> collect() const;
+		sizet totalBytes() const;
+
+		// RGBA8 storage of a loaded texture on the GPU, mipmaps not included. 0 when it isn't loaded
+		static sizet textureBytes(asset<Texture> tex);
+
+	private:
+		vector<std::pair<const void*, Reporter>> mReporters;
+	};
+
+	inline QElangMemoryUsage gEditorMemory;
+}
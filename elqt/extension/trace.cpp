@@ -0,0 +1,137 @@
+#include <elqtpch.h>
+#include "trace.h"
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+
+namespace el
+{
+	namespace
+	{
+		struct TraceEvent
+		{
+			const char* name;
+			int64_t begin, end;
+		};
+
+		struct TraceBuffer
+		{
+			static constexpr sizet cCapacity = 4096;
+
+			TraceEvent events[cCapacity];
+			std::atomic<uint64_t> written;
+			uint lane;
+
+			TraceBuffer(uint lane_) : written(0), lane(lane_) {}
+		};
+
+		// Buffers outlive their threads so a dump still sees finished workers; a new thread takes over a free one,
+		// which keeps the count at the most threads ever alive at once rather than every thread ever started
+		std::mutex sBuffersMutex;
+		vector<std::unique_ptr<TraceBuffer>> sBuffers;
+		vector<TraceBuffer*> sFreeBuffers;
+		fio::path sExitPath;
+
+		struct ThreadBuffer
+		{
+			TraceBuffer* buffer = 0;
+
+			~ThreadBuffer() {
+				if (buffer) {
+					std::lock_guard<std::mutex> lock(sBuffersMutex);
+					sFreeBuffers.push_back(buffer);
+				}
+			}
+
+			TraceBuffer& get() {
+				if (!buffer) {
+					std::lock_guard<std::mutex> lock(sBuffersMutex);
+					if (sFreeBuffers.size() > 0) {
+						buffer = sFreeBuffers.back();
+						sFreeBuffers.pop_back();
+					} else {
+						sBuffers.push_back(std::make_unique<TraceBuffer>((uint)sBuffers.size()));
+						buffer = sBuffers.back().get();
+					}
+				} return *buffer;
+			}
+		};
+
+		thread_local ThreadBuffer tThreadBuffer;
+	}
+
+	int64_t Trace::now() {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	void Trace::record(const char* name, int64_t beginNs, int64_t endNs) {
+		auto& buffer = tThreadBuffer.get();
+		auto index = buffer.written.load(std::memory_order_relaxed);
+		buffer.events[index % TraceBuffer::cCapacity] = { name, beginNs, endNs };
+		buffer.written.store(index + 1, std::memory_order_release);
+	}
+
+	bool Trace::dump(const fio::path& path) {
+		std::ofstream out(path, std::ios::binary);
+		if (!out)
+			return false;
+
+		vector<TraceBuffer*> buffers;
+		{
+			std::lock_guard<std::mutex> lock(sBuffersMutex);
+			for (auto& buffer : sBuffers)
+				buffers.push_back(buffer.get());
+		}
+
+		// Timestamps are written relative to the earliest event, in microseconds
+		int64_t origin = INT64_MAX;
+		for (auto buffer : buffers) {
+			auto written = buffer->written.load(std::memory_order_acquire);
+			for (uint64_t i = (written > TraceBuffer::cCapacity) ? written - TraceBuffer::cCapacity : 0; i < written; i++)
+				origin = min(origin, buffer->events[i % TraceBuffer::cCapacity].begin);
+		}
+
+		out << std::fixed << std::setprecision(3) << "{\"traceEvents\":[";
+		bool first = true;
+		for (auto buffer : buffers) {
+			auto lane = (buffer->lane == 0) ? string("main") : "worker " + std::to_string(buffer->lane);
+			out << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->lane
+				<< ",\"args\":{\"name\":\"" << lane << "\"}}";
+			first = false;
+
+			auto written = buffer->written.load(std::memory_order_acquire);
+			for (uint64_t i = (written > TraceBuffer::cCapacity) ? written - TraceBuffer::cCapacity : 0; i < written; i++) {
+				auto& event = buffer->events[i % TraceBuffer::cCapacity];
+				out << ",\n{\"name\":\"";
+				for (auto c = event.name; *c; c++) {
+					if (*c == '"' || *c == '\\')
+						out << '\\';
+					out << *c;
+				}
+				out << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->lane
+					<< ",\"ts\":" << (event.begin - origin) / 1000.0
+					<< ",\"dur\":" << (event.end - event.begin) / 1000.0 << "}";
+			}
+		}
+		out << "\n]}\n";
+		return (bool)out;
+	}
+
+	void Trace::initFromEnvironment() {
+		auto path = qgetenv("EL_TRACE");
+		if (path.isEmpty())
+			return;
+
+		sExitPath = path.toStdString();
+		enable(true);
+		// The first thread to record gets lane 0, which is the GUI thread when this runs from main
+		tThreadBuffer.get();
+		std::atexit([]() {
+			if (dump(sExitPath))
+				cout << "Trace written to " << sExitPath.generic_u8string() << endl;
+		});
+	}
+}
@@ -0,0 +1,50 @@
+/*****************************************************************//**
+ * @file   trace.h
+ * @brief  Scoped timing events for the editor's long operations, saved as Chrome trace JSON
+ *		   Open the file in chrome://tracing or ui.perfetto.dev.
+ *		   Every thread writes to its own fixed ring of events without locking, the oldest events are overwritten.
+ *		   A scope costs two clock reads while tracing is on and a single flag check while it is off.
+ *
+ *********************************************************************/
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+namespace el
+{
+	struct Trace
+	{
+		static void enable(bool on) { sEnabled.store(on, std::memory_order_relaxed); }
+		static bool enabled() { return sEnabled.load(std::memory_order_relaxed); }
+
+		// Nanoseconds on a monotonic clock
+		static int64_t now();
+		// name must outlive the trace, string literals only
+		static void record(const char* name, int64_t beginNs, int64_t endNs);
+		// Writes the events of every thread, false when the file can't be written.
+		// Events still being written by other threads at that moment may come out garbled
+		static bool dump(const fio::path& path);
+		// Turns tracing on when EL_TRACE holds a file path, the trace is written there on exit
+		static void initFromEnvironment();
+
+	private:
+		inline static std::atomic<bool> sEnabled = false;
+	};
+
+	struct TraceScope
+	{
+		TraceScope(const char* name) : mName(name), mBegin(Trace::enabled() ? Trace::now() : -1) {}
+		~TraceScope() {
+			if (mBegin >= 0)
+				Trace::record(mName, mBegin, Trace::now());
+		}
+
+	private:
+		const char* mName;
+		int64_t mBegin;
+	};
+}
+
+#define EL_TRACE_CONCAT_(a, b) a##b
+#define EL_TRACE_CONCAT(a, b) EL_TRACE_CONCAT_(a, b)
+#define EL_TRACE_SCOPE(name) ::el::TraceScope EL_TRACE_CONCAT(_elTraceScope, __LINE__)(name)
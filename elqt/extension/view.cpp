@@ -7,9 +7,64 @@
 namespace el 
 {
 	bool QElangView::sInitialized = false;
+	bool QElangView::sProfiling = false;
 	signal<> QElangView::sSig_GlobalGL;
 
-	QElangView::QElangView(QWidget* parent) : QOpenGLWidget(parent), mInitialized(false) { }
+	QElangView::QElangView(QWidget* parent) : QOpenGLWidget(parent), mInitialized(false), mProfilerLabel(0), mProfilerFrames(0) { }
+
+	QElangView::~QElangView() {
+		if (mInitialized) {
+			makeCurrent();
+			mProfiler.release();
+		}
+	}
+
+	void QElangView::setProfiling(bool enabled) {
+		sProfiling = enabled;
+		for (auto widget : QApplication::allWidgets()) {
+			if (auto view = qobject_cast<QElangView*>(widget)) {
+				view->mProfiler.resetInputs();
+				view->updateProfilerOverlay();
+				view->update();
+			}
+		}
+	}
+
+	void QElangView::updateProfilerOverlay() {
+		if (!sProfiling) {
+			if (mProfilerLabel)
+				mProfilerLabel->hide();
+			return;
+		}
+
+		if (!mProfilerLabel) {
+			mProfilerLabel = new QLabel(this);
+			mProfilerLabel->setStyleSheet("QLabel { color: white; background-color: rgba(0, 0, 0, 140); padding: 3px; font-family: monospace; }");
+			mProfilerLabel->setAttribute(Qt::WA_TransparentForMouseEvents);
+		}
+
+		using eMetric = ViewProfiler::eMetric;
+		auto name = objectName().isEmpty() ? QString(metaObject()->className()) : objectName();
+		auto text = QString("%1\ncpu  p50 %2  p95 %3  p99 %4 ms")
+			.arg(name)
+			.arg(mProfiler.percentile(eMetric::CpuMs, 50), 0, 'f', 2)
+			.arg(mProfiler.percentile(eMetric::CpuMs, 95), 0, 'f', 2)
+			.arg(mProfiler.percentile(eMetric::CpuMs, 99), 0, 'f', 2);
+		if (mProfiler.hasGpuTimer()) {
+			text += QString("\ngpu  p50 %1  p95 %2  p99 %3 ms")
+				.arg(mProfiler.percentile(eMetric::GpuMs, 50), 0, 'f', 2)
+				.arg(mProfiler.percentile(eMetric::GpuMs, 95), 0, 'f', 2)
+				.arg(mProfiler.percentile(eMetric::GpuMs, 99), 0, 'f', 2);
+		} else text += "\ngpu  no timer queries";
+		text += QString("\ninput  p50 %1  max %2 per frame")
+			.arg(mProfiler.percentile(eMetric::Inputs, 50), 0, 'f', 0)
+			.arg(mProfiler.percentile(eMetric::Inputs, 100), 0, 'f', 0);
+
+		mProfilerLabel->setText(text);
+		mProfilerLabel->adjustSize();
+		mProfilerLabel->move(6, QOpenGLWidget::height() - mProfilerLabel->height() - 6);
+		mProfilerLabel->show();
+	}
 
 
 	void QElangView::initializeGL() {
@@ -24,8 +79,18 @@ namespace el
 	void QElangView::paintGL() { 
 		bindStage();
 		makeCurrent();
+		if (sProfiling)
+			mProfiler.beginFrame();
+
 		updateViewport(-mWidth / 2.0f, mWidth / 2.0f, -mHeight / 2.0f, mHeight / 2.0f);
 		onViewPaint(); 
+
+		if (sProfiling) {
+			mProfiler.endFrame();
+			// The overlay text is refreshed a few times a second, not every frame
+			if (++mProfilerFrames % 15 == 1)
+				updateProfilerOverlay();
+		}
 	}
 	
 	void QElangView::resizeGL(int w, int h) { 
@@ -37,6 +102,8 @@ namespace el
 	}
 
 	void QElangView::mousePressEvent(QMouseEvent* me) {
+		if (sProfiling)
+			mProfiler.countInput();
 		bindStage();
 		makeCurrent();
 
@@ -59,6 +126,8 @@ namespace el
 	}
 
 	void QElangView::mouseReleaseEvent(QMouseEvent* me) {
+		if (sProfiling)
+			mProfiler.countInput();
 		bindStage();
 		makeCurrent();
 
@@ -81,6 +150,8 @@ namespace el
 	}
 
 	void QElangView::mouseMoveEvent(QMouseEvent* me) {
+		if (sProfiling)
+			mProfiler.countInput();
 		bindStage();
 		makeCurrent();
 
@@ -92,6 +163,8 @@ namespace el
 	}
 
 	void QElangView::wheelEvent(QWheelEvent* me) {
+		if (sProfiling)
+			mProfiler.countInput();
 		bindStage();
 		makeCurrent();
 
@@ -104,11 +177,15 @@ namespace el
 	}
 
 	void QElangView::keyPressEvent(QKeyEvent* e) {
+		if (sProfiling)
+			mProfiler.countInput();
 		bindStage();
 		makeCurrent();
 		onViewKeyPress(e);
 	}
 	void QElangView::keyReleaseEvent(QKeyEvent* e) {
+		if (sProfiling)
+			mProfiler.countInput();
 		bindStage();
 		makeCurrent();
 		onViewKeyRelease(e);
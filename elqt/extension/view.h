@@ -11,6 +11,7 @@
 #pragma once
 #include <common/signal.h>
 #include <tools/stage.h>
+#include "view_profiler.h"
 
 namespace el {
 	/**
@@ -25,8 +26,14 @@ namespace el {
 		Q_OBJECT
 	public:
 		QElangView(QWidget* parent = Q_NULLPTR);
+		virtual ~QElangView();
 
 		static signal<> sSig_GlobalGL;
+		// Turns the frame profiler and its overlay on or off for every view
+		static void setProfiling(bool enabled);
+		static bool profiling() { return sProfiling; }
+		const ViewProfiler& profiler() const { return mProfiler; }
+
 		void bindStage() { gStage = mStage; }
 		void setStage(asset<Stage> stage) { mStage = stage; }
 		float width() { return mWidth; }
@@ -59,6 +66,13 @@ namespace el {
 		bool mInitialized;
 		float mWidth, mHeight;
 		asset<Stage> mStage;
+
+	private:
+		static bool sProfiling;
+		ViewProfiler mProfiler;
+		QLabel* mProfilerLabel;
+		uint mProfilerFrames;
+		void updateProfilerOverlay();
 	};
 	/**
 	 * Custom extension for QOpenGLWidget with extra signals.
@@ -0,0 +1,81 @@
+#include <elqtpch.h>
+#include "view_profiler.h"
+
+#include <algorithm>
+
+namespace el
+{
+	void ViewProfiler::Ring::push(float value) {
+		values[next] = value;
+		next = (next + 1) % cHistory;
+		count = min(count + 1, cHistory);
+	}
+
+	ViewProfiler::ViewProfiler() : mQueryNext(0), mQueryPending(0), mInputs(0), mGpuTimer(false), mQueriesMade(false) {}
+
+	void ViewProfiler::beginFrame() {
+		if (!mQueriesMade) {
+			mQueriesMade = true;
+			mGpuTimer = GLEW_VERSION_3_3 || GLEW_ARB_timer_query;
+			if (mGpuTimer)
+				glGenQueries(cQueries, mQueries);
+		}
+
+		// Oldest queries first; once every query is in flight the oldest result is waited on rather than skipped
+		while (mGpuTimer && mQueryPending > 0) {
+			auto oldest = mQueries[(mQueryNext + cQueries - mQueryPending) % cQueries];
+			GLint available = 0;
+			glGetQueryObjectiv(oldest, GL_QUERY_RESULT_AVAILABLE, &available);
+			if (!available && mQueryPending < cQueries)
+				break;
+
+			GLuint64 elapsed = 0;
+			glGetQueryObjectui64v(oldest, GL_QUERY_RESULT, &elapsed);
+			mRings[(int)eMetric::GpuMs].push((float)(elapsed / 1.0e6));
+			mQueryPending--;
+		}
+
+		if (mGpuTimer)
+			glBeginQuery(GL_TIME_ELAPSED, mQueries[mQueryNext]);
+		mStart = std::chrono::steady_clock::now();
+	}
+
+	void ViewProfiler::endFrame() {
+		if (mGpuTimer) {
+			glEndQuery(GL_TIME_ELAPSED);
+			mQueryNext = (mQueryNext + 1) % cQueries;
+			mQueryPending++;
+		}
+
+		auto elapsed = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - mStart).count();
+		mRings[(int)eMetric::CpuMs].push(elapsed);
+		mRings[(int)eMetric::Inputs].push((float)mInputs);
+		mInputs = 0;
+	}
+
+	void ViewProfiler::release() {
+		if (mQueriesMade && mGpuTimer)
+			glDeleteQueries(cQueries, mQueries);
+		mQueriesMade = false;
+		mQueryPending = 0;
+	}
+
+	float ViewProfiler::percentile(eMetric metric, float p) const {
+		auto& ring = mRings[(int)metric];
+		if (ring.count == 0)
+			return -1.0f;
+
+		float sorted[cHistory];
+		std::copy(ring.values, ring.values + ring.count, sorted);
+		auto rank = (int)round(clamp(p, 0.0f, 100.0f) / 100.0f * (ring.count - 1));
+		std::nth_element(sorted, sorted + rank, sorted + ring.count);
+		return sorted[rank];
+	}
+
+	float ViewProfiler::last(eMetric metric) const {
+		auto& ring = mRings[(int)metric];
+		if (ring.count == 0)
+			return -1.0f;
+		return ring.values[(ring.next + cHistory - 1) % cHistory];
+	}
+}
@@ -0,0 +1,62 @@
+/*****************************************************************//**
+ * @file   view_profiler.h
+ * @brief  Per-frame timings of a single QElangView, kept over a rolling window
+ *		   CPU time of paintGL, GPU time through timer queries when the driver has them, and input events per frame.
+ *		   GPU results are read a few frames late so the queries never stall the pipeline.
+ *
+ *********************************************************************/
+#pragma once
+#include <chrono>
+
+namespace el
+{
+	struct ViewProfiler
+	{
+		static constexpr int cHistory = 120;
+
+		enum class eMetric
+		{
+			CpuMs,
+			GpuMs,
+			Inputs,
+			Count
+		};
+
+		ViewProfiler();
+
+		// Both must be called with the view's context current
+		void beginFrame();
+		void endFrame();
+		// Deletes the timer queries, the view's context must be current
+		void release();
+
+		// Inputs are only counted while profiling, the first profiled frame starts from zero
+		void countInput() { mInputs++; }
+		void resetInputs() { mInputs = 0; }
+
+		// Value at percentile p (0 to 100) over the last cHistory frames, -1 with no samples
+		float percentile(eMetric metric, float p) const;
+		float last(eMetric metric) const;
+		sizet samples(eMetric metric) const { return mRings[(int)metric].count; }
+		bool hasGpuTimer() const { return mGpuTimer; }
+
+	private:
+		struct Ring
+		{
+			float values[cHistory];
+			int count, next;
+
+			Ring() : count(0), next(0) {}
+			void push(float value);
+		};
+
+		static constexpr int cQueries = 4;
+
+		Ring mRings[(int)eMetric::Count];
+		std::chrono::steady_clock::time_point mStart;
+		GLuint mQueries[cQueries];
+		int mQueryNext, mQueryPending;
+		uint mInputs;
+		bool mGpuTimer, mQueriesMade;
+	};
+}
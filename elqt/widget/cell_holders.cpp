@@ -0,0 +1,36 @@
+#include <elqtpch.h>
+#include "cell_holders.h"
+
+#include <tools/cell.h>
+
+namespace el
+{
+	void createCellHolders(asset<Atlas> atlas, IButtonEvent* events) {
+		auto& meta = atlas.get<AtlasMeta>();
+		for (auto i = 0; i < meta.cellorder.size(); i++) {
+			asset<CellMeta> cm = meta.cellorder[i];
+			if (cm.has<CellHolder>()) {
+				cm.get<CellHolder>().button.setEvent(events);
+			} else {
+				auto& cell = cm.get<Cell>();
+
+				Box rect;
+				rect.l = cell.uvLeft * meta.width;
+				rect.r = cell.uvRight * meta.width;
+				rect.b = -cell.uvDown * meta.height;
+				rect.t = -cell.uvUp * meta.height;
+
+				gProject.emplace<CellHolder>(cm, rect, events);
+			}
+		}
+	}
+
+	void updateCellHolderButtons(const AtlasMeta& meta, vec2 pos) {
+		for (auto i = 0; i < meta.cellorder.size(); i++) {
+			if (asset<CellHolder> holder = meta.cellorder[i]) {
+				bool hit = holder->rect.contains(pos);
+				holder->button.update(holder, hit);
+			}
+		}
+	}
+}
@@ -0,0 +1,71 @@
+/*****************************************************************//**
+ * @file   cell_holders.h
+ * @brief  Walks over the cell holders of an atlas, shared by the palette widgets and the atlas benchmark
+ *		   None of them touch GL, so the benchmark times exactly what the widgets run
+ *
+ *********************************************************************/
+
+#pragma once
+#include "palette.h"
+#include <tools/atlas.h>
+
+namespace el
+{
+	// Gives every cell of atlas a CellHolder over its texture rect, holders that already exist are pointed at events
+	void createCellHolders(asset<Atlas> atlas, IButtonEvent* events);
+	// Updates the button of every holder with whether pos, in texture space, lies inside its rect
+	void updateCellHolderButtons(const AtlasMeta& meta, vec2 pos);
+
+	// Clears Selected and tags every holder whose rect touches band with it
+	template<typename Selected>
+	void selectCellHolders(const AtlasMeta& meta, const Box& band) {
+		gProject.clear<Selected>();
+		for (asset<CellHolder> holder : meta.cellorder) {
+			if (holder->rect.intersects(band))
+				gProject.get_or_emplace<Selected>(holder);
+		}
+	}
+
+	// Outline walk of a palette rebatch over region, at scale world units per screen pixel.
+	// Cells at least a pixel wide go to outline(rect), smaller ones are merged into overview blocks of blockPixels
+	// pixels given to overview(box), and holders of atlas tagged Selected inside region go to selected(rect)
+	template<typename Selected, typename Outline, typename Overview, typename Fill>
+	void walkCellOutlines(asset<Atlas> atlas, const Box& region, float scale, float blockPixels, Outline&& outline, Overview&& overview, Fill&& selected) {
+		auto block = blockPixels * scale;
+		int columns = max(1, (int)ceil(region.width() / block));
+		int rows = max(1, (int)ceil(region.height() / block));
+		vector<char> blocks;
+
+		for (asset<CellHolder> holder : atlas.get<AtlasMeta>().cellorder) {
+			auto& rect = holder->rect;
+			if (!rect.intersects(region))
+				continue;
+
+			if (max(rect.width(), rect.height()) >= scale) {
+				outline(rect);
+			} else {
+				if (blocks.empty())
+					blocks.assign((sizet)columns * rows, 0);
+				int x = clamp((int)((rect.l - region.l) / block), 0, columns - 1);
+				int y = clamp((int)((region.t - rect.t) / block), 0, rows - 1);
+				blocks[(sizet)y * columns + x] = 1;
+			}
+		}
+
+		if (!blocks.empty()) {
+			for (int y = 0; y < rows; y++) {
+				for (int x = 0; x < columns; x++) {
+					if (blocks[(sizet)y * columns + x]) {
+						auto l = region.l + x * block, t = region.t - y * block;
+						overview(Box(l, t - block, l + block, t));
+					}
+				}
+			}
+		}
+
+		for (asset<CellHolder> holder : gProject.view<Selected>()) {
+			if (holder.get<SubAssetData>().parent == atlas && holder->rect.intersects(region))
+				selected(holder->rect);
+		}
+	}
+}
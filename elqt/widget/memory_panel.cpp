@@ -0,0 +1,99 @@
+#include <elqtpch.h>
+#include "memory_panel.h"
+#include "../extension/memory_usage.h"
+
+#include <QTreeWidget>
+#include <QHeaderView>
+#include <map>
+#include <algorithm>
+
+namespace el
+{
+	QElangMemoryPanel::QElangMemoryPanel(QWidget* parent) : QDockWidget("Memory Usage", parent) {
+		setObjectName("MemoryUsagePanel");
+
+		auto body = new QWidget(this);
+		auto layout = new QVBoxLayout(body);
+		layout->setContentsMargins(4, 4, 4, 4);
+
+		mTree = new QTreeWidget(body);
+		mTree->setHeaderLabels({ "Asset", "CPU", "GPU" });
+		mTree->setRootIsDecorated(true);
+		mTree->setUniformRowHeights(true);
+		mTree->header()->setSectionResizeMode(0, QHeaderView::Stretch);
+		mTree->header()->setSectionResizeMode(1, QHeaderView::ResizeToContents);
+		mTree->header()->setSectionResizeMode(2, QHeaderView::ResizeToContents);
+		mTree->header()->setStretchLastSection(false);
+		layout->addWidget(mTree);
+
+		mTotal = new QLabel(body);
+		layout->addWidget(mTotal);
+		setWidget(body);
+
+		mTimer = new QTimer(this);
+		connect(mTimer, &QTimer::timeout, this, &QElangMemoryPanel::refresh);
+	}
+
+	QString QElangMemoryPanel::formatBytes(sizet bytes, bool estimate) {
+		QString prefix = estimate ? "~" : "";
+		if (bytes >= (sizet)1 << 30)
+			return prefix + QString::number(bytes / double(1 << 30), 'f', 2) + " GB";
+		if (bytes >= (sizet)1 << 20)
+			return prefix + QString::number(bytes / double(1 << 20), 'f', 1) + " MB";
+		if (bytes >= (sizet)1 << 10)
+			return prefix + QString::number(bytes / double(1 << 10), 'f', 1) + " KB";
+		return prefix + QString::number(bytes) + " B";
+	}
+
+	void QElangMemoryPanel::refresh() {
+		struct Group { sizet cpu = 0, gpu = 0; bool estimate = false; vector<MemoryUsage> rows; };
+		std::map<string, Group> groups;
+		sizet cpu = 0, gpu = 0;
+		for (auto& row : gEditorMemory.collect()) {
+			auto& group = groups[row.group];
+			group.cpu += row.cpuBytes;
+			group.gpu += row.gpuBytes;
+			group.estimate |= row.estimate;
+			group.rows.push_back(row);
+			cpu += row.cpuBytes;
+			gpu += row.gpuBytes;
+		}
+
+		// Expanded groups stay expanded across refreshes
+		QSet<QString> expanded;
+		for (int i = 0; i < mTree->topLevelItemCount(); i++) {
+			if (mTree->topLevelItem(i)->isExpanded())
+				expanded.insert(mTree->topLevelItem(i)->text(0));
+		}
+
+		// Largest group first, rows inside come sorted from collect
+		vector<std::pair<const string, Group>*> order;
+		for (auto& pair : groups)
+			order.push_back(&pair);
+		std::stable_sort(order.begin(), order.end(), [](auto lhs, auto rhs) {
+			return lhs->second.cpu + lhs->second.gpu > rhs->second.cpu + rhs->second.gpu;
+		});
+
+		mTree->clear();
+		for (auto pair : order) {
+			auto& group = pair->second;
+			auto name = QString::fromUtf8(pair->first);
+			auto top = new QTreeWidgetItem(mTree, { name, formatBytes(group.cpu, group.estimate), formatBytes(group.gpu, group.estimate) });
+			for (auto& row : group.rows)
+				new QTreeWidgetItem(top, { QString::fromUtf8(row.name), formatBytes(row.cpuBytes, row.estimate), formatBytes(row.gpuBytes, row.estimate) });
+			top->setExpanded(expanded.contains(name));
+		}
+		mTotal->setText("Total  CPU " + formatBytes(cpu) + "   GPU " + formatBytes(gpu));
+	}
+
+	void QElangMemoryPanel::showEvent(QShowEvent* e) {
+		QDockWidget::showEvent(e);
+		refresh();
+		mTimer->start(1000);
+	}
+
+	void QElangMemoryPanel::hideEvent(QHideEvent* e) {
+		QDockWidget::hideEvent(e);
+		mTimer->stop();
+	}
+}
@@ -0,0 +1,33 @@
+/*****************************************************************//**
+ * @file   memory_panel.h
+ * @brief  Dockable table of gEditorMemory, grouped and sorted by size
+ *		   Refreshes once a second while it is visible. Estimated sizes are marked with ~
+ *
+ *********************************************************************/
+#pragma once
+#include <QDockWidget>
+
+class QTreeWidget;
+
+namespace el
+{
+	class QElangMemoryPanel : public QDockWidget
+	{
+		Q_OBJECT
+
+	public:
+		QElangMemoryPanel(QWidget* parent = Q_NULLPTR);
+
+		void refresh();
+		static QString formatBytes(sizet bytes, bool estimate = false);
+
+	protected:
+		void showEvent(QShowEvent* e) override;
+		void hideEvent(QHideEvent* e) override;
+
+	private:
+		QTreeWidget* mTree;
+		QLabel* mTotal;
+		QTimer* mTimer;
+	};
+}
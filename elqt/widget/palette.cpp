@@ -1,5 +1,6 @@
 #include <elqtpch.h>
 #include "palette.h"
+#include "cell_holders.h"
 
 #include <apparatus/ui.h>
 #include <tools/material.h>
@@ -8,10 +9,12 @@
 #include <tools/atlas.h>
 
 #include "../color_code.h"
+#include "../extension/gl_resources.h"
+#include "../extension/trace.h"
 
 namespace el {
 	QElangPaletteWidget::QElangPaletteWidget(QWidget* parent, bool internalLoop)
-		: QElangTextureWidget(parent, internalLoop), mHighlightBatched(false), mCellShapes(0)
+		: QElangTextureWidget(parent, internalLoop), mHighlightBatched(false), mCellShapes(0), mBatchedBox(0, 0, 0, 0), mBatchedScale(0.0f)
 	{
 		ui.view->setMouseTracking(true);
 
@@ -21,6 +24,7 @@ namespace el {
 		});
 
 		ui.view->sig_Paint.connect([&]() {
+			syncBatchedView();
 			mCellShapes->draw();
 			mHighlighter->draw();
 			mHighlightBatched = false;
@@ -45,6 +49,11 @@ namespace el {
 		ui.view->update();
 	}
 
+	void QElangPaletteWidget::refreshSelection() {
+		rebatchCellShapes();
+		ui.view->update();
+	}
+
 	void QElangPaletteWidget::loop() {
 		if (isActiveWindow() && mMainCam) {
 			if (gMouse.state(1) == eInput::Hold) {
@@ -73,49 +82,61 @@ namespace el {
 
 	void QElangPaletteWidget::recreateCellHoldersFromAtlas() {
 		if (mAtlas && mAtlas.has<AssetLoaded>()) {
-			auto& meta = mAtlas.get<AtlasMeta>();
-
-			for (auto i = 0; i < meta.cellorder.size(); i++) {
-				asset<CellMeta> cm = meta.cellorder[i];
-				if (cm.has<CellHolder>()) {
-					cm.get<CellHolder>().button.setEvent(this);
-				} else {
-					auto& cell = cm.get<Cell>();
-
-					Box rect;
-					rect.l = cell.uvLeft * meta.width;
-					rect.r = cell.uvRight * meta.width;
-					rect.b = -cell.uvDown * meta.height;
-					rect.t = -cell.uvUp * meta.height;
-
-					gProject.emplace<CellHolder>(cm, rect, this);
-				}
-			}
+			EL_TRACE_SCOPE("recreateCellHoldersFromAtlas");
+			createCellHolders(mAtlas, this);
 		}
 	}
 	
+	// Side in screen pixels of the overview blocks standing in for sub-pixel cells
+	static const float cOverviewPixels = 4.0f;
+
 	void QElangPaletteWidget::rebatchAllCellHolders() {
 		if (mAtlas && mAtlas.has<AssetLoaded>() && mCellShapes) {
-			auto& cells = mAtlas.get<AtlasMeta>().cellorder;
-			forceUnlockDebuggers();
+			mHighlighter->line.forceUnlock();
+			mHighlighter->fill.forceUnlock();
+			rebatchCellShapes();
+		}
+	}
+
+	void QElangPaletteWidget::rebatchCellShapes() {
+		if (mAtlas && mAtlas.has<AssetLoaded>() && mCellShapes) {
+			mCellShapes->line.forceUnlock();
+			mCellShapes->fill.forceUnlock();
 			resetMainCamera();
-			for (asset<CellHolder> holder : cells) {
-				mCellShapes->line.batchAABB(holder->rect, gEditorColor.cell);
-			}
-			for (asset<CellHolder> holder : gProject.view<PaletteSelectedCell>()) {
-				if (holder.get<SubAssetData>().parent == mAtlas) {
-					auto color = gEditorColor.cell;
-					color.a = 80;
-					mCellShapes->fill.batchAABB(holder->rect, color);
-				}
-			}
+
+			// Half a view of margin on every side, so short pans draw from the same batch
+			auto view = viewBox();
+			auto mx = view.width() / 2.0f, my = view.height() / 2.0f;
+			mBatchedBox = Box(view.l - mx, view.b - my, view.r + mx, view.t + my);
+			mBatchedScale = (mMainCam && mMainCam->scale().x > 0.0f) ? mMainCam->scale().x : 1.0f;
+
+			auto overview = gEditorColor.cell, selected = gEditorColor.cell;
+			overview.a = 120;
+			selected.a = 80;
+			walkCellOutlines<PaletteSelectedCell>(mAtlas, mBatchedBox, mBatchedScale, cOverviewPixels,
+				[&](const Box& rect) { mCellShapes->line.batchAABB(rect, gEditorColor.cell); },
+				[&](const Box& block) { mCellShapes->fill.batchAABB(block, overview); },
+				[&](const Box& rect) { mCellShapes->fill.batchAABB(rect, selected); });
 			mCellShapes->line.flags |= ePainterFlags::LOCKED;
 			mCellShapes->fill.flags |= ePainterFlags::LOCKED;
 		}
 	}
 
+	void QElangPaletteWidget::syncBatchedView() {
+		if (!mCellShapes || !mMainCam || mBatchedScale <= 0.0f)
+			return;
+
+		auto view = viewBox();
+		bool inside = view.l >= mBatchedBox.l && view.r <= mBatchedBox.r && view.b >= mBatchedBox.b && view.t <= mBatchedBox.t;
+		// Small zoom steps keep the batch, the overview blocks are off by at most a quarter then
+		bool zoomed = abs(mMainCam->scale().x / mBatchedScale - 1.0f) > 0.25f;
+		if (!inside || zoomed)
+			rebatchCellShapes();
+	}
+
 	void QElangPaletteWidget::forceUnlockDebuggers() {
 		mCellShapes->line.forceUnlock();
+		mCellShapes->fill.forceUnlock();
 		mHighlighter->line.forceUnlock();
 		mHighlighter->fill.forceUnlock();
 	}
@@ -131,15 +152,9 @@ namespace el {
 	
 	void QElangPaletteWidget::updateAllHolderCheck() {
 		if (mMaterial && mMaterial->hasTexture() && mAtlas && mMainCam) {
-			auto& cells = mAtlas.get<AtlasMeta>().cellorder;
 			auto pos = *mMainCam * gMouse.currentPosition();
 			mHovering = NullEntity;
-			for (auto i = 0; i < cells.size(); i++) {
-				if (asset<CellHolder> holder = cells[i]) {
-					bool hit = holder->rect.contains(pos);
-					holder->button.update(holder, hit);
-				}
-			}
+			updateCellHolderButtons(mAtlas.get<AtlasMeta>(), pos);
 			if (gMouse.state(0) == eInput::Lift)
 				mHeld = NullEntity;
 
@@ -161,11 +176,8 @@ namespace el {
 	void QElangPaletteWidget::safeCreatePalette() {
 		if (!mCellShapes) {
 			ui.view->makeCurrent();
-			mCellShapes = new ShapeDebug2d;
-			mCellShapes->init(mMainCam);
-
-			mHighlighter = new ShapeDebug2d;
-			mHighlighter->init(mMainCam);
+			mCellShapes = gEditorGL.acquireShapes(mMainCam);
+			mHighlighter = gEditorGL.acquireShapes(mMainCam);
 		}
 	}
 
@@ -181,6 +193,7 @@ namespace el {
 					sig_Clicked.invoke(mHovering);
 					gProject.clear<PaletteSelectedCell>();
 					mHovering.add<PaletteSelectedCell>();
+					rebatchCellShapes();
 				}
 			}
 
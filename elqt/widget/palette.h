@@ -12,6 +12,7 @@
 
 #pragma once
 #include "texture_widget.h"
+#include "../extension/gl_resources.h"
 #include <elements/button.h>
 #include <tools/cell.h>
 
@@ -57,27 +58,36 @@ namespace el {
 		void release() override {
 			QElangTextureWidget::release();
 			if (mCellShapes) {
-				delete mCellShapes;
-				delete mHighlighter;
-				mCellShapes = 0;
+				gEditorGL.release(mCellShapes);
+				gEditorGL.release(mHighlighter);
 			}
 		}
 
 		// Update atlas using an asset entity that holds the Atlas.
 		// If you reimport or modify the atlas, you must call this method again
 		virtual void updateAtlas(asset<Atlas>);
+		// Redraws the selected-cell fill after PaletteSelectedCell changed outside this palette
+		void refreshSelection();
 
 	protected:
 		asset<Atlas> mAtlas;
 		asset<CellHolder> mHovering, mHeld;
 		bool mHighlightBatched;
 		ShapeDebug2d* mCellShapes, *mHighlighter;
+		// Region and zoom the cell outlines were last batched for; views that stay inside and near that zoom reuse it
+		Box mBatchedBox;
+		float mBatchedScale;
 
 		void safeCreatePalette();
 		void forceUnlockDebuggers();
 		void resetMainCamera();
 		void recreateCellHoldersFromAtlas();
+		// Batches the outlines around the current view. Cells under a pixel at this zoom become coarse overview blocks
 		void rebatchAllCellHolders();
+		// Same batch without clearing the hover highlight, for rebatches from inside a paint
+		void rebatchCellShapes();
+		// Rebatches when the view panned out of the batched region or the zoom moved too far from it
+		void syncBatchedView();
 		void updateAllHolderCheck();
 		void updateCursor();
 
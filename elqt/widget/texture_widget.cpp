@@ -10,6 +10,7 @@
 #include <tools/material.h>
 #include <tools/texture.h>
 #include <tools/atlas.h>
+#include "../extension/gl_resources.h"
 
 namespace el
 {
@@ -37,12 +38,8 @@ namespace el
 			glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
 			glClearColor(0.2f, 0.3f, 0.2f, 1.0f);
-			if (!mPainter) {
-				mPainter = gProject.make<Painter>("__el_editor_/shader/basic_sprite.vert", "__el_editor_/shader/texture_uv.frag",
-					100000, mMainCam, Projection::eOrtho,
-					ePainterFlags::DEPTH_SORT | ePainterFlags::MULTI_MATERIAL | ePainterFlags::Z_CLEAR).add<EditorAsset>();
-				mPainter->init();
-			}
+			if (!mPainter)
+				mPainter = gEditorGL.acquireSpritePainter(QElangGLResources::cMinCapacity, mMainCam);
 
 			safeCreateObjects();
 		});
@@ -85,7 +82,7 @@ namespace el
 		if (mMainCam) {
 			ui.view->makeCurrent();
 			mMainCam.destroy();
-			mPainter.destroy();
+			gEditorGL.release(mPainter);
 		}
 	}
 
@@ -203,6 +200,16 @@ namespace el
 		}
 	}
 
+	Box QElangTextureWidget::viewBox() {
+		if (!mMainCam)
+			return mMainCamBox;
+
+		auto w = round(ui.view->width());
+		auto h = round(ui.view->height());
+		Box box = *mMainCam * aabb(-w / 2.0f, -h / 2.0f, w / 2.0f, h / 2.0f);
+		return box;
+	}
+
 	void QElangTextureWidget::syncScrollBars() {
 		if (mMainCam) {
 			mSuppressScroll = true;
@@ -74,6 +74,8 @@ namespace el
 		void syncCameraTarget(); // fixed
 		void syncScrollBars(); // fixed
 		void syncScrollBarPositionToCam();
+		// World box the main camera shows right now, following it while it tweens. mMainCamBox is where it is headed
+		Box viewBox();
 		virtual void release();
 	};
 
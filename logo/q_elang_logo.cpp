@@ -1,11 +1,12 @@
 #include <elqtpch.h>
 #include "q_elang_logo.h"
 #include <apparatus/asset_loader.h>
+#include "../elqt/extension/trace.h"
 
 namespace el
 {
 	QElangLogo::QElangLogo(QWidget* parent)
-		: QWidget(parent) {
+		: QWidget(parent), mWidget(0), mLabel(0), mLoaded(false) {
 		setWindowFlags(Qt::FramelessWindowHint | Qt::WindowStaysOnTopHint);
 		setAttribute(Qt::WA_NoSystemBackground);
 		setAttribute(Qt::WA_TranslucentBackground);
@@ -46,10 +47,12 @@ namespace el
 				if (mCounter == 0 && mWidget) {
 					cout << "Initializing GLEW..." << endl;
 					glewInit();
+					EL_TRACE_SCOPE("importNativeGUI");
 					AssetLoader loader;
 					cout << "Importing Native GUI..." << endl;
 					loader.initNativeGUI();
 					loader.importAllNativeGUIAssets();
+					mLoaded = true;
 					sig_Loaded.invoke();
 				}
 			}
@@ -57,6 +60,8 @@ namespace el
 	}
 
 	void QElangLogo::closeEvent(QCloseEvent* e) {
+		if (!mLoaded)
+			cout << "Splash closed before loading, native GUI assets were not imported" << endl;
 		mLogo = QImage();
 		delete mWidget;
 		mWidget = 0;
@@ -66,4 +71,4 @@ namespace el
 	
 
 	}
-}
\ No newline at end of file
+}
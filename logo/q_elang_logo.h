@@ -21,10 +21,13 @@ namespace el
 		QLabel* mLabel;
 
 		int mCounter;
+		bool mLoaded;
 	public:
 		QElangLogo(QWidget* parent = nullptr);
 		~QElangLogo();
 
+		// Fires once the native GUI assets are imported. The import blocks the GUI thread in a single
+		// AssetLoader call; closing the splash before it started cancels it and this never fires
 		signal<> sig_Loaded;
 
 	private: